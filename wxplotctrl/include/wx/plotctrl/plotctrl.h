@@ -11,10 +11,13 @@
 #ifndef _WX_PLOTCTRL_H_
 #define _WX_PLOTCTRL_H_
 
+#include <functional>
 #include <limits>
+#include <vector>
 
 #include "wx/bitmap.h"
 #include "wx/window.h"
+#include "wx/longlong.h"
 
 #include "wx/plotctrl/plotdata.h"
 #include "wx/plotctrl/plotmark.h"
@@ -35,6 +38,8 @@ class wxPlotDrawerYAxis;
 class wxPlotDrawerKey;
 class wxPlotDrawerDataCurve;
 class wxPlotDrawerMarker;
+class wxPlotPickBuffer;
+class wxPlotRenderThread;
 
 //-----------------------------------------------------------------------------
 // wxPlot Constants
@@ -52,6 +57,124 @@ WX_DECLARE_OBJARRAY_WITH_DECL(wxPoint2DDouble, wxArrayPoint2DDouble, class);
 WX_DECLARE_OBJARRAY_WITH_DECL(wxRect2DDouble,  wxArrayRect2DDouble, class);
 WX_DECLARE_OBJARRAY_WITH_DECL(wxPlotData,      wxArrayPlotData, class);
 
+//-----------------------------------------------------------------------------
+// wxPlotDataPredicate - a test of the points of a wxPlotData for selecting them
+//   eg. wxPlotDataPredicate::Above(wxPlotDataPredicate::Value::ABS_Y, 2.5)
+//   NaN values only pass the IS_NAN test
+//-----------------------------------------------------------------------------
+
+class wxPlotDataPredicate
+{
+public:
+    // Which value of the points is tested
+    enum class Value
+    {
+        X,
+        Y,
+        ABS_X,
+        ABS_Y
+    };
+
+    enum class Test
+    {
+        ABOVE,    // value >  min
+        BELOW,    // value <  max
+        INSIDE,   // value >= min and value <= max
+        OUTSIDE,  // value <  min or  value >  max
+        IS_NAN,   // value is NaN
+        FUNCTION  // function(x, y) returns true
+    };
+
+    typedef std::function<bool (double x, double y)> Function;
+
+    static wxPlotDataPredicate Above(Value value, double threshold)
+        {return wxPlotDataPredicate(Test::ABOVE, value, threshold, threshold);}
+    static wxPlotDataPredicate Below(Value value, double threshold)
+        {return wxPlotDataPredicate(Test::BELOW, value, threshold, threshold);}
+    static wxPlotDataPredicate Inside(Value value, double min, double max)
+        {return wxPlotDataPredicate(Test::INSIDE, value, min, max);}
+    static wxPlotDataPredicate Outside(Value value, double min, double max)
+        {return wxPlotDataPredicate(Test::OUTSIDE, value, min, max);}
+    static wxPlotDataPredicate IsNaN(Value value)
+        {return wxPlotDataPredicate(Test::IS_NAN, value, 0, 0);}
+    static wxPlotDataPredicate Where(const Function &function)
+        {wxPlotDataPredicate p(Test::FUNCTION, Value::Y, 0, 0); p.function_ = function; return p;}
+
+    Test GetTest() const {return test_;}
+    Value GetValue() const {return value_;}
+    double GetMin() const {return min_;}
+    double GetMax() const {return max_;}
+
+    // Get the x range of the points that can pass, or false if it's unbounded
+    bool GetXRange(double &min, double &max) const;
+
+    // Test count points, setting pass[i] to 1 if they pass and 0 if not
+    void Evaluate(const double *xs, const double *ys, int count, unsigned char *pass) const;
+
+protected:
+    wxPlotDataPredicate(Test test, Value value, double min, double max)
+        : test_(test), value_(value), min_(min), max_(max) {}
+
+    Test     test_;
+    Value    value_;
+    double   min_;
+    double   max_;
+    Function function_;
+};
+
+//-----------------------------------------------------------------------------
+// wxPlotCurveTree - bounding volume hierarchy of the curves' bounding rects
+//   used by wxPlotCtrl::FindCurve to test only the curves near a point.
+//   Curves are kept by their index in the wxPlotCtrl, a dynamic AABB tree
+//   updated a leaf at a time, rebuilt when it gets too unbalanced.
+//-----------------------------------------------------------------------------
+
+class wxPlotCurveTree
+{
+public:
+    wxPlotCurveTree() : root_(-1) {}
+
+    void Clear();
+    int GetCount() const {return int(leaves_.size());}
+
+    // Add a curve with index GetCount() and its wxPlotData::GetDataVersion
+    void Add(const wxRect2DDouble &rect, unsigned long version);
+    // Remove the curve at index, the ones after it move down one
+    void Remove(int index);
+    // Set the rect and version of the curve at index, returns false if
+    //   the rect is unchanged
+    bool Update(int index, const wxRect2DDouble &rect, unsigned long version);
+    // Get the version of the curve's data the rect at index was taken from
+    unsigned long GetVersion(int index) const {return nodes_[leaves_[index]].version_;}
+
+    // Get the indexes of the curves whose rects intersect the rect, unsorted
+    void Query(const wxRect2DDouble &rect, std::vector<int> &indexes) const;
+
+protected:
+    struct Node
+    {
+        wxRect2DDouble rect_;
+        int parent_;
+        int child1_;  // -1 for leaves
+        int child2_;
+        int index_;   // of the curve for leaves
+        int height_;  // 0 for leaves
+        unsigned long version_; // of the curve for leaves
+    };
+
+    int  NewNode();
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    void Refit(int node);  // the rects and heights of node and up
+    int  Build(int *leaves, int count, int parent);
+    void Rebuild();
+
+    std::vector<Node> nodes_;
+    std::vector<int>  freeNodes_;
+    std::vector<int>  leaves_;  // node of each curve
+    int root_;
+};
+
 
 
 //-----------------------------------------------------------------------------
@@ -147,6 +270,7 @@ public:
         wxRect mouseDragRectangle_; // mouse drag rectangle, or 0,0,0,0 when not dragging
         wxPoint lastMousePosition_;
         wxBitmap bitmap_;
+        wxBitmap shiftBitmap_; // reused by wxPlotCtrl::ShiftOrigin
         wxPlotCtrl *host_;
 
     private:
@@ -286,12 +410,24 @@ public:
     bool SelectDataRange(int curve_index, const wxRangeInt &range, bool sendEvent = false);
     bool DeselectDataRange(int curve_index, const wxRangeInt &range, bool sendEvent = false);
 
+    // Select the points that pass the predicate, eg. all |y| > 2.5
+    //   the whole curve is tested and selected at once, sending a single event,
+    //   large curves are tested on several threads unless the test is a function
+    //   if there's nothing to select or already selected it returns false
+    //   if curveIndex == -1 then try to select points in all curves
+    //   this ONLY works for wxPlotData curves
+    bool SelectWhere(int curveIndex, const wxPlotDataPredicate &predicate, bool sendEvent = false);
+    bool DeselectWhere(int curveIndex, const wxPlotDataPredicate &predicate, bool sendEvent = false);
+
     // Clear the ranges, if curve_index = -1 then clear them all
     bool ClearSelectedRanges(int curveIndex, bool sendEvent = false);
 
     // internal use, or not...
     virtual bool DoSelectRectangle(int curveIndex, const wxRect2DDouble &rect, bool select, bool sendEvent = false);
     virtual bool DoSelectDataRange(int curveIndex, const wxRangeInt &range, bool select, bool sendEvent = false);
+    virtual bool DoSelectWhere(int curveIndex, const wxPlotDataPredicate &predicate, bool select, bool sendEvent = false);
+    // merge the sorted runs into the selection with one redraw and event
+    virtual bool DoSelectDataRanges(int curveIndex, const wxRangeIntSelection &runs, bool select, bool sendEvent = false);
     // called from DoSelect... when selecting to ensure that the current selection
     // matches the SetSelectionType by unselecting as appropriate
     // The input curveIndex implies that a selection will be made for that curve
@@ -315,6 +451,9 @@ public:
 
     // Set the origin of the plot window
     bool SetOrigin(double origin_x, double origin_y, bool sendEvent = false);
+    // Move the plot by dx, dy pixels, the area bitmap is shifted and only the
+    //   newly exposed strips are drawn
+    bool ShiftOrigin(int dx, int dy, bool sendEvent = false);
 
     // Get the bounds of the plot window view in plot coords
     const wxRect2DDouble &GetViewRect() const;
@@ -331,6 +470,11 @@ public:
     // Zoom in client coordinates, window.[xy] is top left (unlike plot axis)
     bool SetZoom(const wxRect &window, bool sendEvent = false);
 
+    // When the area is slow to draw, show the last one scaled to the new view
+    //   at once and draw the exact one in idle time (default true)
+    bool GetZoomPreview() const;
+    void SetZoomPreview(bool preview = true);
+
     // Set/Get the default size the plot should take when either no curves are
     //   loaded or only plot(curves/functions) that have no bounds are loaded
     //   The width and the height must both be > 0
@@ -348,6 +492,10 @@ public:
     void NextHistoryView(bool foward, bool sendEvent = false);
     int GetHistoryViewCount() const;
     int GetHistoryViewIndex() const;
+    // Keep up to count rendered views to flip back to at once with
+    //   NextHistoryView while nothing else has changed, 0 (default) disables it
+    int GetHistoryCacheSize() const;
+    void SetHistoryCacheSize(int count);
 
     // Fix the aspect ratio of the x and y axes, if set then when the zoom is
     //  set the smaller of the two (x or y) zooms is multiplied by the ratio
@@ -399,6 +547,28 @@ public:
     bool GetDrawSpline() const;
     void SetDrawSpline(bool drawSpline = true);
 
+    // Draw the data points as a density map instead of lines, symbols or
+    //   splines, in shades of each curve's pen colour by the number of points
+    //   on each pixel on a log scale
+    bool GetDrawDensity() const;
+    void SetDrawDensity(bool drawDensity = true);
+
+    // Keep the curve and data index drawn at each pixel of the area, so the
+    //   mouse finds points with a lookup instead of searching the curves and
+    //   MOUSE_MOTION events have the curve and point under the mouse
+    bool GetUsePickBuffer() const;
+    void SetUsePickBuffer(bool usePickBuffer = true);
+
+    // Draw a decimated preview of large curves at once, then refine it in idle time
+    bool GetProgressiveDraw() const;
+    void SetProgressiveDraw(bool progressive = true);
+
+    // Keep showing the last complete area while the next one is drawn by a
+    //   worker thread, or in idle time if it can't draw it (splines, density,
+    //   pens that aren't solid or no threads), stale ones are dropped unfinished
+    bool GetAsyncDraw() const;
+    void SetAsyncDraw(bool async = true);
+
     // Draw the plot grid over the whole window, else just tick marks at edge
     bool GetDrawGrid() const;
     void SetDrawGrid(bool drawGrid = true);
@@ -533,6 +703,16 @@ public:
     virtual void ProcessAreaMouseEvent(wxMouseEvent &event);
     virtual void ProcessAxisMouseEvent(wxMouseEvent &event);
 
+    // wxEVT_PLOTCTRL_MOUSE_MOTION events are sent at most once every
+    //   interval ms for the latest mouse position, 0 sends one per motion
+    int GetMouseMotionInterval() const;
+    void SetMouseMotionInterval(int ms);
+    // Stop building motion events for a while when nobody processed the
+    //   last one, a handler that calls Skip() counts as not processing it
+    //   so it only gets one event a second, to see if it wants them again
+    bool GetSkipUnhandledMouseMotion() const { return skipUnhandledMotion_; }
+    void SetSkipUnhandledMouseMotion(bool skip);
+
     // EVT_CHAR from the area and axis windows are passed to these functions
     virtual void ProcessAreaCharEvent(wxKeyEvent &event);
     virtual void ProcessAreaKeyDownEvent(wxKeyEvent &event);
@@ -559,10 +739,23 @@ public:
 
     // Redraw parts of the plotctrl using combinations of RedrawNeed
     void Redraw(int need);
+    // Redraw for a new view or size only, the cached frames of the history
+    //   views stay valid, see SetHistoryCacheSize
+    void RedrawView(int need);
+    // Redraw only this rect of the area window (client coords), the dirty
+    //   rects are collected and redrawn together on the next paint
+    void RedrawRect(const wxRect &rect);
     // Get/Set the redraw need variable (this is for internal use, see redraw())
     int GetRedrawNeeds() const;
     void SetRedrawNeeds(int need);
 
+    // Redraws, view shifts and scrollbar updates are collected and done
+    //   together at most once every interval ms, 0 does them immediately
+    int GetFrameInterval() const;
+    void SetFrameInterval(int ms);
+    // Do the collected redraw work now, the paint handlers call this first
+    void FlushFrame();
+
     // Draw a marker in lower right signifying that this has the focus
     virtual void DrawActiveBitmap(wxDC *dc);
     // Draw the wxPlotCtrl (this window)
@@ -571,6 +764,9 @@ public:
     virtual void DrawAreaWindow(wxDC *dc, const wxRect &rect);
     // Draw a wxPlotData derived curve
     virtual void DrawDataCurve(wxDC *dc, wxPlotData *curve, int curve_index, const wxRect &rect);
+    // Draw the points [startIndex, endIndex) of a curve, every stride'th one
+    void DrawDataCurvePart(wxDC *dc, wxPlotData *curve, int curve_index, const wxRect &rect,
+                           int startIndex, int endIndex, int stride);
     // Draw the key
     virtual void DrawKey(wxDC *dc);
     // Draw the left click drag marker, type is wxPlotCtrl_Marker_Type
@@ -587,6 +783,8 @@ public:
     void DrawSmithChartGrid(wxDC *dc, const wxRect &rect);
     // Draw markers
     virtual void DrawMarkers(wxDC *dc, const wxRect &rect);
+    // Draw the background, border and grid or tick marks of the area window
+    void DrawAreaBackground(wxDC *dc, const wxRect &rect);
 
     // redraw this wxPlotData between these two indexes (for (de)select redraw)
     virtual void RedrawCurve(int index, int minIndex, int maxIndex);
@@ -626,12 +824,34 @@ public:
     // curvePt fills the exact point in the curve.
     bool FindCurve(const wxPoint2DDouble &pt, const wxPoint2DDouble &dxdyPt,
                    int &curveIndex, int &data_index, wxPoint2DDouble *curvePt = NULL) const;
+    // Find a line between points of a curve within +- dxdyPt of pt, starting
+    // with active curve, return sucess, setting curve_index, the indexes of
+    // the points at either end, and if curvePt the nearest point on the line.
+    bool FindCurveSegment(const wxPoint2DDouble &pt, const wxPoint2DDouble &dxdyPt,
+                          int &curveIndex, int &index0, int &index1,
+                          wxPoint2DDouble *curvePt = NULL) const;
+
+    // Find the point drawn within radius pixels of the client point using the
+    //   pick buffer, returns false if none or if the buffer isn't up to date
+    //   curvePt is the point, or the nearest one on the line if a line was
+    //   found, data_index is then the nearer end of it
+    bool FindPickedPoint(const wxPoint &clientPt, int radius,
+                         int &curveIndex, int &data_index,
+                         wxPoint2DDouble *curvePt = NULL) const;
+    // Is the pick buffer used and drawn for the current view
+    bool IsPickBufferValid() const;
+    // Get the value of every curve at x, interpolated as wxPlotData::GetY(x, index)
+    //   and NaN for invalid curves, the segment found for each curve is kept
+    //   so nearby x (eg. a moving crosshair) are found quickly next time,
+    //   very many curves are split between threads with wxPlotParallelFor
+    void GetValuesAtX(double x, std::vector<double> &values) const;
 
     // if n is !finite send wxEVT_PLOTCTRL_ERROR if msg is not empty
     bool IsFinite(double n, const wxString &msg = wxEmptyString) const;
 
     // call this whenever you adjust the size of a data curve
-    //    this necessary to know the default zoom to show them
+    //    this necessary to know the default zoom to show them,
+    //    and for FindCurve to find them where they are now
     void CalcBoundingPlotRect();
 
     // Client (pixels) to/from plot (double) coords
@@ -661,6 +881,11 @@ public:
                            h < INT_MAX ? int(h) : INT_MAX);
         }
 
+    // Convert count plot coords to client coords at once, as above but
+    //   saturated to the int range at both ends, NaN gives INT_MAX
+    void GetClientCoordsFromPlotX(const double *plotx, int *clientx, int count) const;
+    void GetClientCoordsFromPlotY(const double *ploty, int *clienty, int count) const;
+
     // Get the windows
 
     // internal use size adjustment
@@ -671,13 +896,21 @@ public:
     // who's got the focus, if this then draw the bitmap to show it, internal
     bool CheckFocus();
 
-    // send event returning true if it's allowed
-    bool DoSendEvent(wxPlotCtrlEvent &event) const;
+    // send event returning true if it's allowed, processed is set to whether
+    //   a handler processed it without calling Skip()
+    bool DoSendEvent(wxPlotCtrlEvent &event, bool *processed = NULL) const;
+    // Send the motion event now or start the motion timer to send it later
+    void QueueMouseMotionEvent();
+    // Send the motion event for the area's last mouse position
+    void SendMouseMotionEvent();
 
     void StartMouseTimer(wxWindowID win_id);
     void StopMouseTimer();
     bool IsTimerRunning();
     void OnTimer(wxTimerEvent &event);
+#if wxUSE_THREADS
+    void OnRenderThread(wxThreadEvent &event);
+#endif
 
     // A locker for the captured window, set to NULL to release
     void SetCaptureWindow(wxWindow *win);
@@ -733,6 +966,7 @@ protected:
     bool drawSymbols_;
     bool drawLines_;
     bool drawSpline_;
+    bool drawDensity_;
     bool drawGrid_;
     bool drawTicks_;
     bool fitOnNewCurve_;
@@ -755,6 +989,8 @@ protected:
     // bounding rect, (GetLeft,GetTop) is lower left in screen coords
     wxRect2DDouble viewRect_;          // part of the plot currently displayed
     wxRect2DDouble curveBoundingRect_; // total extent of the plot - CalcBoundingPlotRect
+    wxPlotCurveTree curveTree_;        // curves' bounding rects - UpdateCurveTree
+    mutable std::vector<int> valueIndexes_; // segment per curve - GetValuesAtX
     wxRect2DDouble defaultPlotRect_;   // default extent of the plot, fallback
     wxRect areaClientRect_;            // rect of (wxPoint(0,0), PlotArea.GetClientSize())
 
@@ -789,6 +1025,136 @@ protected:
     int redrawNeed_;
     int batchCount_;
 
+    // everything the cached background layer of the area window depends on
+    struct AreaLayerKey
+    {
+        wxRect2DDouble viewRect_;
+        wxSize size_;
+        GridType gridType_;
+        wxColour backgroundColour_;
+        wxColour gridColour_;
+        wxColour borderColour_;
+        int borderWidth_;
+        bool drawGrid_;
+        bool drawTicks_;
+        wxArrayInt bottomTicks_;
+        wxArrayInt leftTicks_;
+
+        bool operator==(const AreaLayerKey &other) const;
+    };
+    AreaLayerKey GetAreaLayerKey() const;
+
+    // a rendered view kept for NextHistoryView
+    struct HistoryFrame
+    {
+        wxRect2DDouble viewRect_;
+        wxPoint2DDouble zoom_;
+        wxSize size_;
+        unsigned long styleVersion_;   // styleVersion_ it was drawn with
+        std::vector<unsigned long> curveVersions_; // see GetCurveVersions
+        wxBitmap area_;
+        wxBitmap bottomAxis_;
+        wxBitmap leftAxis_;
+    };
+    // Remember the area and axes as they're shown now, if they're complete
+    void CacheHistoryFrame();
+    // Show the cached frame of the current view, returns false if there's none
+    bool RestoreHistoryFrame();
+
+    std::vector<HistoryFrame> historyFrames_; // most recently used first
+    int historyCacheSize_;
+    unsigned long styleVersion_;       // bumped by any redraw but RedrawView
+    // Get the data and pen versions of the curves, in pairs
+    void GetCurveVersions(std::vector<unsigned long> &versions) const;
+
+    // Get the client rect a marker covers in the area window
+    wxRect GetMarkerClientRect(const wxPlotMarker &marker) const;
+    // Redraw the key at its old and new position
+    void RedrawKey();
+
+    wxRegion dirtyRegion_;             // out of date parts of the area bitmap
+    int redrawSpanCurve_;              // the only curve changed in it, else -1
+    wxRangeInt redrawSpan_;            // and the points to draw of it
+    // Get the points of a curve to draw in the rect, all but those clearly
+    //   outside of it if the x values are ordered
+    void GetCurveSpanInRect(wxPlotData *curve, const wxRect &rect, int &start, int &end) const;
+    // rebuild the stale cached layers, returns the topmost one to blit from
+    const wxBitmap &UpdateAreaLayers();
+
+    wxBitmap backgroundLayer_;         // background, border and grid
+    AreaLayerKey backgroundLayerKey_;
+    wxBitmap markersLayer_;            // backgroundLayer_ with plotMarkers_ on top
+    unsigned long markersVersion_;     // bumped whenever plotMarkers_ may change
+    unsigned long markersLayerVersion_;
+    bool markersLayerValid_;
+    bool useAreaLayers_;               // false when drawing to a printer dc
+
+    // Get the stride to draw a curve with in the preview, 1 for every point,
+    //   see wxPlotDrawerDataCurve::GetPreviewIndexes for how it is decimated
+    int GetPreviewStride(wxPlotData *curve) const;
+    // Draw the cursor, key and border on top of the curves
+    void DrawAreaForeground(wxDC *dc, const wxRect &rect);
+    // The crosshair, mouse marker and cursor are drawn over the area bitmap
+    //   in Area::OnPaint, these refresh just the parts of the area they cover
+    void RefreshAreaOverlay(const wxRect &rect);
+    void RefreshCrosshairCursor(const wxPoint &pos);
+    void RefreshMouseMarker(MarkerType type, const wxRect &rect);
+    // Get black or white, whichever shows up on the background
+    wxColour GetOverlayColour() const;
+    // Draw the next slice of the full detail area, returns true if not done
+    bool RefineAreaBitmap();
+    // Start drawing the area on the render thread or in idle time unless
+    //   it's already being drawn
+    void StartAsyncFrame();
+    // Send a copy of the curves to the render thread, false if it can't draw them
+    bool RequestRenderFrame();
+    // Scale and move the area bitmap from the view it shows to the current one
+    void PreviewAreaView();
+    // Get the curves whose bounds are within +- dpt of pt, the active one first
+    void GetCurvesNear(const wxPoint2DDouble &pt, const wxPoint2DDouble &dpt,
+                       std::vector<int> &curves) const;
+    // Add new curves to the curve tree and move the ones whose data changed,
+    //   done by CalcBoundingPlotRect so the queries don't scan the curves
+    void UpdateCurveTree();
+
+    // Redraw without waiting for the next frame
+    void DoRedraw(int need);
+    // Move the view so the ticks of the changed axes fall on whole pixels
+    void CorrectAxisTicks(bool correctX, bool correctY);
+    // Start the frame timer, or flush at once if the interval is 0
+    void ScheduleFrame();
+    bool IsFramePending() const;
+    // Shift the area bitmap by the pixels the view moved since it was drawn
+    void ShiftArea(int dx, int dy, int axisNeed);
+
+    wxTimer *frameTimer_;              // see ScheduleFrame
+    int frameInterval_;
+    int frameNeed_;                    // RedrawNeed collected for the next frame
+    wxPoint frameShift_;               // ShiftOrigin pixels collected for it
+    bool frameScrollBars_;
+
+    wxTimer *motionTimer_;             // see QueueMouseMotionEvent
+    int motionInterval_;
+    wxLongLong lastMotionTime_;        // when the last motion event was sent
+    bool skipUnhandledMotion_;
+    bool motionUnhandled_;             // nobody processed the last one
+
+    bool progressiveDraw_;
+    bool asyncDraw_;
+    bool zoomPreview_;
+    bool areaPreview_;                 // area bitmap is a preview, see PreviewAreaView
+    wxRect2DDouble bitmapView_;        // view and zoom the area bitmap shows
+    wxPoint2DDouble bitmapZoom_;
+    long lastAreaDrawTime_;            // ms to draw the whole area last time
+    wxBitmap refineBitmap_;            // full detail area drawn in idle time
+    int refinePos_;                    // curve being refined, -1 if not refining
+    int refineIndex_;                  // next data point of that curve
+    wxPlotPickBuffer *pickBuffer_;       // of the area bitmap, see SetUsePickBuffer
+    wxPlotPickBuffer *refinePickBuffer_; // of the refineBitmap_
+    wxPlotRenderThread *renderThread_;   // see SetAsyncDraw, made when first needed
+    unsigned long renderGeneration_;   // bumped whenever the area is out of date
+    unsigned long renderRequested_;    // generation last sent to the render thread
+
     wxSize axisFontSize_;      // pixel size of the number '5' for axis font
     int    leftAxisTextWidth_; // size of "-5e+005" for max y axis width
     int    areaBorderWidth_;   // width of area border pen (default 1)
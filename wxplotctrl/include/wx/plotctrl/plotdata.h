@@ -11,6 +11,8 @@
 #ifndef _WX_PLOTDATA_H_
 #define _WX_PLOTDATA_H_
 
+#include <functional>
+
 #include "wx/geometry.h"
 #include "wx/clntdata.h"
 
@@ -23,6 +25,13 @@ extern double LinearInterpolateX(double x0, double y0,
                                   double x1, double y1,
                                   double y);
 
+// Call func(start, end) for parts of [0, count) of at least minCount items,
+//   run on worker threads if there are enough and more than one cpu, else
+//   all at once on this thread. func must only write to its own part and
+//   mustn't use the GUI or copy ref counted objects like wxPlotData.
+extern void wxPlotParallelFor(size_t count, size_t minCount,
+                              const std::function<void (size_t start, size_t end)> &func);
+
 extern const wxRect2DDouble wxNullPlotBounds;
 WX_DECLARE_OBJARRAY_WITH_DECL(wxPen, wxArrayPen, class);
 
@@ -85,6 +94,13 @@ public:
     // ALWAYS call CalcBoundingRect after externally modifying the data,
     // especially if reording X quantities and using the wxPlotCtrl
     virtual void CalcBoundingRect();
+    // A number unique to the current contents of the data, it changes whenever
+    //   CalcBoundingRect is called, use it to tell when cached results are stale
+    unsigned long GetDataVersion() const;
+    // Are all the points finite with ascending x, as found by CalcBoundingRect
+    bool GetIsXOrdered() const;
+    // A number unique to the current pens, it changes whenever SetPen is called
+    unsigned long GetPenVersion() const;
 
     //-------------------------------------------------------------------------
     // Get/Set data values
@@ -101,6 +117,15 @@ public:
     // Interpolate if necessary to get the y value at this point,
     //   doesn't fail just returns ends if out of bounds
     double GetY(double x) const;
+    // Like GetY(x), but x-ordered data is searched from index, the segment
+    //   found for a nearby x before or -1, and index is set to this one.
+    //   It may differ from GetY(x) in the last bits, at duplicate xs it
+    //   gives the last of them and a NaN x gives the first point.
+    double GetY(double x, int &index) const;
+    // Same as GetY(x, index) for each of the n xs, for x-ordered data and
+    //   ascending xs it's a single walk along both, large arrays are split
+    //   between threads with wxPlotParallelFor
+    void GetY(const double *xs, double *ys, size_t n) const;
 
     enum class IndexType
     {
@@ -117,6 +142,12 @@ public:
     // find the first occurance of an index whose value is closest to x,y
     //    if x_range != 0 then limit search between +- x_range (useful for x-ordered data)
     int GetIndexFromXY(double x, double y, double x_range=0) const;
+    // find the first line segment between consecutive points nearest to x,y
+    //    distances are in units of dx, dy (eg. a pixel) and must be <= 1
+    //    returns false if none, else the indexes of the ends of the segment
+    //    and the fraction t of the way from index0 to index1 of the nearest point
+    bool GetSegmentFromXY(double x, double y, double dx, double dy,
+                          int &index0, int &index1, double *t = NULL) const;
 
     //-------------------------------------------------------------------------
     // Get/Set Symbols to use for plotting - CreateSymbol is untested
@@ -11,9 +11,15 @@
 #ifndef _WX_PLOTDRAW_H_
 #define _WX_PLOTDRAW_H_
 
+#include <vector>
+
 #include "wx/plotctrl/plotmark.h"
 #include "wx/plotctrl/range.h"
 
+#if wxUSE_THREADS
+    #include "wx/thread.h"
+#endif
+
 class wxDC;
 
 class wxRangeIntSelection;
@@ -151,6 +157,11 @@ public:
 
     void SetKeyPosition(const wxPoint &pos);
 
+    // Get the rect the key covered when last drawn, empty if it wasn't drawn
+    const wxRect &GetLastKeyRect() const;
+    // Get the rect the key would cover if drawn on this dc now
+    wxRect GetKeyRect(wxDC *dc, const wxString &keyString) const;
+
     // implementation
     wxFont font_;
     wxColour fontColour_;
@@ -159,11 +170,64 @@ public:
     int border_;
     int keyLineWidth_;  // length of line to draw for curve
     int keyLineMargin_; // margin between line and key text
+    wxRect lastKeyRect_;
 
 private:
+    // set the key font on the dc and find the rect of the text
+    wxRect CalcTextRect(wxDC *dc, const wxString &keyString, int *heightLine) const;
+
     DECLARE_ABSTRACT_CLASS(wxPlotDrawerKey);
 };
 
+//-----------------------------------------------------------------------------
+// wxPlotPickBuffer - the curve and data index drawn last at each pixel
+//   of the area, see wxPlotCtrl::SetUsePickBuffer
+//-----------------------------------------------------------------------------
+
+class wxPlotPickBuffer
+{
+public:
+    wxPlotPickBuffer() {}
+
+    // Resize to size and clear it, for drawing the view at the zoom
+    void Reset(const wxSize &size, const wxRect2DDouble &view, const wxPoint2DDouble &zoom);
+    // Clear the pixels in the rect
+    void Clear(const wxRect &rect);
+    // Move the pixels by dx, dy clearing the ones uncovered, for the view
+    void Shift(int dx, int dy, const wxRect2DDouble &view);
+    // Mark it as not showing any view until the next Reset
+    void Invalidate() {view_ = wxRect2DDouble(0, 0, 0, 0);}
+
+    // Set a pixel of the point index, or of the line from it to other
+    inline void SetPixel(int i, int j, int curve, int index, int other = -1)
+    {
+        if ((i >= 0) && (i < size_.x) && (j >= 0) && (j < size_.y))
+        {
+            size_t p = size_t(j)*size_.x + i;
+            curves_[p] = curve;
+            indexes_[p] = index;
+            others_[p] = other;
+        }
+    }
+    // Set the pixels of a line within clip, the first half gets index0
+    void SetLine(int i0, int j0, int i1, int j1, const wxRect &clip,
+                 int curve, int index0, int index1);
+    // Set the data version of the curve being drawn
+    void SetDataVersion(int curve, unsigned long version);
+
+    // Find the nearest set pixel within radius of pt, returns false if none,
+    //   other is the far end if it's of a line or else -1
+    bool Find(const wxPoint &pt, int radius, int &curve, int &index, int *other = NULL) const;
+
+    wxSize          size_;
+    wxRect2DDouble  view_;          // the view and zoom it was drawn for
+    wxPoint2DDouble zoom_;
+    std::vector<int> curves_;       // per pixel, -1 if nothing was drawn
+    std::vector<int> indexes_;      // per pixel
+    std::vector<int> others_;       // per pixel, the far end of a line or -1
+    std::vector<unsigned long> dataVersions_; // by curve index when drawn
+};
+
 //-----------------------------------------------------------------------------
 // wxPlotDrawerDataCurve
 //-----------------------------------------------------------------------------
@@ -174,6 +238,100 @@ public:
     wxPlotDrawerDataCurve(wxPlotCtrl *host);
     virtual void Draw(wxDC *dc, bool refresh);
     virtual void Draw(wxDC *dc, wxPlotData *plotData, int curveIndex);
+    // Draw the points [startIndex, endIndex) of the curve, a decimated preview
+    // if stride > 1, see GetPreviewIndexes. Consecutive parts must overlap by
+    // one point.
+    virtual void Draw(wxDC *dc, wxPlotData *plotData, int curveIndex,
+                      int startIndex, int endIndex, int stride = 1);
+
+    // Draw a curve in consecutive parts, each with DrawPart between BeginParts
+    //   and EndParts. The parts share the symbol mask and the density counts
+    //   so they look like the curve drawn at once, EndParts draws the density.
+    void BeginParts();
+    void DrawPart(wxDC *dc, wxPlotData *plotData, int curveIndex, int startIndex, int endIndex);
+    void EndParts(wxDC *dc, wxPlotData *plotData, int curveIndex);
+
+    // the spline through a curve subdivided in plot coords
+    struct SplineCache
+    {
+        unsigned long dataVersion_ = 0; // wxPlotData::GetDataVersion
+        wxPoint2DDouble zoom_;         // zoom the subdivision was made for
+        bool tooLarge_ = false;        // drawn without the cache instead
+        std::vector<double> xs_;
+        std::vector<double> ys_;
+        std::vector<int> index_;       // data point each piece is centred on
+    };
+
+    // the pens of a curve scaled by the pen scale, by wxPlotData::PenColorType
+    struct PenCache
+    {
+        unsigned long penVersion_ = 0; // wxPlotData::GetPenVersion
+        double penScale_ = 0;
+        wxPen pens_[3];
+    };
+
+    // bits per pixel of the dc rect, cleared by moving on to a new stamp so
+    //   the memory is only set when the size changes or the stamps run out
+    struct PixelMask
+    {
+        std::vector<unsigned int> marks_; // the stamp << 2 | the bits
+        unsigned int stamp_ = 0;
+
+        void Reset(size_t pixels);
+        inline unsigned int Get(size_t p) const
+            {return ((marks_[p] >> 2) == stamp_) ? (marks_[p] & 3) : 0;}
+        inline void Set(size_t p, unsigned int bits)
+            {marks_[p] = (stamp_ << 2) | Get(p) | bits;}
+        inline size_t GetCount() const {return marks_.size();}
+    };
+
+    // points per pixel of the dc rect, only the pixels counted are cleared
+    struct PixelCounts
+    {
+        std::vector<unsigned int> counts_;
+        std::vector<size_t> touched_;     // pixels with counts, in order counted
+
+        void Reset(size_t pixels);
+        inline void Add(size_t p, unsigned int n)
+            {if (counts_[p] == 0) touched_.push_back(p); counts_[p] += n;}
+        inline size_t GetCount() const {return counts_.size();}
+    };
+
+    // Set the pick buffer to fill as the curves are drawn, NULL for none
+    void SetPickBuffer(wxPlotPickBuffer *pickBuffer) {pickBuffer_ = pickBuffer;}
+
+protected:
+    // Get the scaled pens of the curve, only remade when they're changed
+    const PenCache &GetPenCache(wxPlotData *curve, int curveIndex);
+    // Get the points a preview of [startIndex, endIndex) draws, the first,
+    //   last, lowest and highest of each pixel column of x-ordered data, or of
+    //   each stride points if it isn't, so the peaks aren't lost
+    void GetPreviewIndexes(wxPlotData *curve, int startIndex, int endIndex,
+                           int stride, std::vector<int> &indexes);
+    // Count the points on each pixel, drawn as a density map unless drawing
+    //   parts, see wxPlotCtrl::SetDrawDensity
+    void DrawDensity(wxDC *dc, wxPlotData *curve, int curveIndex,
+                     int startIndex, int endIndex, int stride);
+    // Draw the counts as a map in shades of the curve's pen colour, pixels
+    //   with selected points in the selected pen's colour
+    void DrawDensityMap(wxDC *dc, wxPlotData *curve, int curveIndex,
+                        const PixelCounts &counts, const PixelMask &mask);
+    // Get the spline of the curve for the current zoom, NULL if it's too large
+    const SplineCache *GetSplineCache(wxPlotData *curve, int curveIndex);
+    void DrawSplineCache(wxDC *dc, const SplineCache &cache, int curveIndex,
+                         const wxPen &currentPen, const wxPen &selectedPen,
+                         const wxRect2DDouble &viewRect, const wxRect2DDouble &drawRect);
+
+    std::vector<SplineCache> splineCaches_; // by curve index
+    std::vector<PenCache> penCaches_;       // by curve index
+    PixelMask pixelMask_;                   // of each curve drawn
+    PixelCounts pixelCounts_;
+    PixelMask partsMask_;                   // the same for all the parts so far
+    PixelCounts partsCounts_;
+    std::vector<int> previewIndexes_;       // see GetPreviewIndexes
+    int partsEnd_;                          // end of the last part drawn
+    bool inParts_;                          // in DrawPart
+    wxPlotPickBuffer *pickBuffer_;          // not owned, see SetPickBuffer
 
 private:
     DECLARE_ABSTRACT_CLASS(wxPlotDrawerDataCurve);
@@ -196,4 +354,87 @@ private:
     DECLARE_ABSTRACT_CLASS(wxPlotDrawerMarker);
 };
 
+#if wxUSE_THREADS
+
+//-----------------------------------------------------------------------------
+// wxPlotRenderFrame - a copy of what's needed to draw the curves of the area,
+//   made on the GUI thread for wxPlotRenderThread, and the pixels it draws
+//   The points are copied, the curves may change while the thread draws.
+//   Only solid lines of the pen width and the 2x2 symbols of
+//   wxPlotDrawerDataCurve are drawn, wxPlotCtrl doesn't use the thread for
+//   curves with other pen styles, splines or density maps.
+//-----------------------------------------------------------------------------
+
+class wxPlotRenderFrame
+{
+public:
+    struct Curve
+    {
+        std::vector<double> xs_;           // the points that can be seen
+        std::vector<double> ys_;
+        int first_;                        // data index of the first of them
+        wxRangeIntSelection selection_;
+        unsigned char colour_[3];          // of the normal or active pen
+        unsigned char selectedColour_[3];
+        int width_;                        // pen widths in pixels
+        int selectedWidth_;
+    };
+
+    wxPlotRenderFrame() : generation_(0), drawLines_(true),
+                          drawSymbols_(true), complete_(false) {}
+
+    unsigned long generation_;         // of the area when it was requested
+    wxSize size_;                      // of the area in pixels
+    wxRect2DDouble view_;
+    wxPoint2DDouble zoom_;
+    bool drawLines_;
+    bool drawSymbols_;
+    std::vector<Curve> curves_;        // in drawing order, active one last
+
+    std::vector<unsigned char> rgba_;  // size_ pixels, alpha 0 where empty
+    bool complete_;                    // false if it was dropped unfinished
+};
+
+//-----------------------------------------------------------------------------
+// wxPlotRenderThread - draws wxPlotRenderFrames into memory without a wxDC
+//   Only the newest frame requested is drawn, older ones are dropped as soon
+//   as a new one comes. A wxEVT_THREAD event with the id is queued to the
+//   handler when a frame is done, get it with TakeDone.
+//-----------------------------------------------------------------------------
+
+class wxPlotRenderThread: public wxThread
+{
+public:
+    wxPlotRenderThread(wxEvtHandler *handler, int id);
+    virtual ~wxPlotRenderThread();
+
+    // Draw this frame next, takes ownership, call from the GUI thread only
+    void Request(wxPlotRenderFrame *frame);
+    // Get the frames done since the last call, the caller deletes them
+    void TakeDone(std::vector<wxPlotRenderFrame*> &frames);
+    // Drop the frame being drawn and wait for the thread to end, it must
+    //   have been Run
+    void Stop();
+
+protected:
+    virtual ExitCode Entry();
+
+    // Draw the curves into the rgba_ of the frame, false if it was dropped
+    bool Render(wxPlotRenderFrame &frame);
+    // Has a newer frame been requested or the thread been stopped
+    bool IsStale(const wxPlotRenderFrame &frame);
+
+    wxEvtHandler *handler_;
+    int id_;
+
+    wxMutex mutex_;                    // guards all below
+    wxCondition condition_;            // signalled on a request or stop
+    wxPlotRenderFrame *next_;          // waiting to be drawn, or NULL
+    std::vector<wxPlotRenderFrame*> done_;
+    unsigned long latest_;             // generation of the newest request
+    bool stop_;
+};
+
+#endif // wxUSE_THREADS
+
 #endif
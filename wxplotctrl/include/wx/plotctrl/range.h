@@ -13,10 +13,11 @@
 #include "wx/defs.h"
 #include "wx/dynarray.h"
 
+#include <vector>
+
 class wxRangeInt;
 class wxRangeIntSelection;
 
-WX_DECLARE_OBJARRAY_WITH_DECL(wxRangeInt, wxArrayRangeInt, class);
 WX_DECLARE_OBJARRAY_WITH_DECL(wxRangeIntSelection, wxArrayRangeIntSelection, class);
 
 //=============================================================================
@@ -108,8 +109,140 @@ public:
     int m_min, m_max;
 };
 
+//=============================================================================
+// wxArrayRangeInt - contiguous array of wxRangeInts with the wxObjArray interface
+//=============================================================================
+
+// the compare function for wxArrayRangeInt::Sort, as for a wxObjArray
+typedef int (wxCMPFUNC_CONV *CMPFUNCwxRangeInt)(wxRangeInt **item1, wxRangeInt **item2);
+
+class wxArrayRangeInt : public std::vector<wxRangeInt>
+{
+public:
+    wxArrayRangeInt() {}
+    wxArrayRangeInt(size_t count, const wxRangeInt &range) : std::vector<wxRangeInt>(count, range) {}
+
+    inline size_t GetCount() const {return size();}
+    inline size_t Count() const {return size();}
+    inline bool IsEmpty() const {return empty();}
+    inline void Clear() {clear();}
+    inline void Empty() {clear();}
+    inline void Alloc(size_t count) {reserve(count);}
+    inline void Shrink() {shrink_to_fit();}
+
+    inline wxRangeInt& Item(size_t index) {return (*this)[index];}
+    inline const wxRangeInt& Item(size_t index) const {return (*this)[index];}
+    inline wxRangeInt& Last() {return back();}
+    inline const wxRangeInt& Last() const {return back();}
+
+    // Get the index of the first (or last) range equal to this, or wxNOT_FOUND
+    int Index(const wxRangeInt &range, bool fromEnd = false) const;
+
+    inline void Add(const wxRangeInt &range, size_t copies = 1) {insert(end(), copies, range);}
+    // Add or insert a range created with new, the array deletes it
+    void Add(const wxRangeInt *range);
+    inline void Insert(const wxRangeInt &range, size_t index, size_t copies = 1)
+        {insert(begin() + index, copies, range);}
+    void Insert(const wxRangeInt *range, size_t index);
+    inline void RemoveAt(size_t index, size_t count = 1)
+        {erase(begin() + index, begin() + index + count);}
+    // Remove the first range equal to this one
+    void Remove(const wxRangeInt &range);
+    // Remove the range at index and return it created with new, delete it
+    wxRangeInt *Detach(size_t index);
+
+    void Sort(CMPFUNCwxRangeInt compare);
+};
+
+//=============================================================================
+// wxBitmapIntSelection - compressed bitmap of selected ints >= 0
+//   The ints are split into chunks of 65536, each stored as a list of runs if
+//   it has only a few or else as a bitmap, like a roaring bitmap. Used by a
+//   wxRangeIntSelection that is fragmented into many small ranges.
+//=============================================================================
+
+class wxBitmapIntSelection
+{
+public:
+    wxBitmapIntSelection() : m_runCount(-1) {}
+
+    // Replace the contents with the sorted non overlapping ranges
+    void Assign(const wxArrayRangeInt &ranges);
+    // Get the contents as sorted non overlapping ranges
+    void GetRanges(wxArrayRangeInt &ranges) const;
+    void Clear() {m_chunks.clear(); m_runCount = -1;}
+
+    inline bool IsEmpty() const {return m_chunks.empty();}
+    bool Contains(int i) const;
+    // Get the number of selected items, and of runs of them
+    int GetItemCount() const;
+    int GetRunCount() const;
+    wxRangeInt GetBoundingRange() const;
+
+    // Get the first run that ends at or after i, returns false if there is none
+    bool NextRange(int i, wxRangeInt &range) const;
+    // Get the run at index in order, returns false if index is out of range
+    bool GetRun(int index, wxRangeInt &range) const;
+    // Get the index of the run with i in it, or wxNOT_FOUND
+    int RunIndex(int i) const;
+    // Get the index of the last run that starts at or before i, -1 if none
+    int NearestRunIndex(int i) const;
+
+    // Set or clear the items in the range, returns true if anything changed
+    bool SetRange(const wxRangeInt &range);
+    bool ClearRange(const wxRangeInt &range);
+
+    enum class Op
+    {
+        UNION,
+        INTERSECT,
+        SUBTRACT
+    };
+
+    // Combine with the other a chunk at a time, words at a time where either
+    //   has bits, returns true if anything changed, changed gets the items
+    //   added for UNION or removed for INTERSECT and SUBTRACT
+    bool Combine(const wxBitmapIntSelection &other, Op op, wxBitmapIntSelection *changed = NULL);
+
+protected:
+    struct Chunk
+    {
+        int key_ = 0;                   // items key_*65536 to key_*65536 + 65535
+        int count_ = 0;                 // number of items set
+        mutable int starts_ = -1;       // cached Starts(65536), -1 if it needs counting
+        std::vector<wxRangeInt> runs_;  // the runs as offsets from the start, or
+        std::vector<wxUint64> words_;   // the bits, if there are too many runs
+
+        bool Contains(int off) const;
+        int NextSet(int off) const;     // first set at or after off, -1 if none
+        int RunEnd(int off) const;      // last set of the run with off in it
+        int RunStart(int off) const;    // first set of the run with off in it
+        int LastSet() const;            // -1 if none
+        int Starts(int off) const;      // runs starting before off, one at 0 counts
+        int StartCount() const;         // Starts(65536), cached
+        int NthStart(int n) const;      // offset of the start Starts counted n-th
+        void SetRange(int lo, int hi);
+        void ClearRange(int lo, int hi);
+        void Recount();                 // count_ from the runs or bits
+        void GetWords(wxUint64 *words) const;  // the bits however they're stored
+        void SetWords(const wxUint64 *words);  // store as runs or bits, the smaller
+        void Compact();                 // bits if too many runs, runs if only a few
+        void Combine(const Chunk &other, Op op, Chunk *changed);
+    };
+
+    size_t ChunkIndex(int key) const;   // of the first chunk >= key
+    bool Joined(size_t c) const;        // does a run go on into chunk c from c-1
+    void UpdateRunStarts() const;
+    int RunsBefore(int i) const;        // number of runs starting before i
+
+    std::vector<Chunk> m_chunks;        // sorted by key, none empty
+    mutable int m_runCount;             // cached, -1 if it needs counting
+    mutable std::vector<int> m_runStarts; // runs starting before each chunk, with m_runCount
+};
+
 //=============================================================================
 // wxRangeIntSelection - ordered 1D array of wxRangeInts, combines to minimze size
+//   switches to a wxBitmapIntSelection when fragmented, see Optimize
 //=============================================================================
 
 class wxRangeIntSelection
@@ -120,29 +253,27 @@ public:
     wxRangeIntSelection(const wxRangeIntSelection &ranges) {Copy(ranges);}
 
     // Make a full copy of the source
-    void Copy(const wxRangeIntSelection &source)
-    {
-        m_ranges.Clear();
-        WX_APPEND_ARRAY(m_ranges, source.GetRangeArray());
-    }
+    void Copy(const wxRangeIntSelection &source);
 
     // Get the number of individual ranges
-    inline int GetCount() const {return m_ranges.GetCount();}
+    int GetCount() const;
     // Get total number of items selected in all ranges, ie. sum of all wxRange::GetWidths
     int GetItemCount() const;
     // Get the ranges themselves to iterate though for example
-    const wxArrayRangeInt& GetRangeArray() const {return m_ranges;}
-    // Get a single range
-    const wxRangeInt& GetRange(int index) const;
-    inline const wxRangeInt& Item(int index) const {return GetRange(index);}
+    //   a fragmented selection has to make them, prefer NextRange
+    const wxArrayRangeInt& GetRangeArray() const;
+    // Get a single range, by value since a fragmented selection makes it
+    //   from the bitmap
+    wxRangeInt GetRange(int index) const;
+    inline wxRangeInt Item(int index) const {return GetRange(index);}
     // Get a range of the min range value and max range value
     wxRangeInt GetBoundingRange() const;
     // Clear all the ranges
-    void Clear() {m_ranges.Clear();}
+    void Clear();
 
     // Is this point or range contained in the selection
-    inline bool Contains(int i) const {return Index(i) != wxNOT_FOUND;}
-    inline bool Contains(const wxRangeInt &range) const {return Index(range) != wxNOT_FOUND;}
+    bool Contains(int i) const;
+    bool Contains(const wxRangeInt &range) const;
     // Get the index of the range that contains this, or wxNOT_FOUND
     int Index(int i) const;
     int Index(const wxRangeInt &range) const;
@@ -151,6 +282,8 @@ public:
     //   returns -1 if it's below all the selected ones, or no ranges
     //   returns GetCount() if it's above all the selected ones
     int NearestIndex(int i) const;
+    // Get the first range that ends at or after i, returns false if there is none
+    bool NextRange(int i, wxRangeInt &range) const;
 
     // Add the range to the selection, returning if anything was done, false if already selected
     bool SelectRange(const wxRangeInt &range);
@@ -158,16 +291,49 @@ public:
     // Remove the range to the selection, returning if anything was done, false if not already selected
     bool DeselectRange(const wxRangeInt &range);
 
+    // Add or remove all the ranges at once, merging the sorted lists in one pass
+    //   returns if anything was done, changed gets the items that were (de)selected
+    bool SelectRanges(const wxRangeIntSelection &ranges, wxRangeIntSelection *changed = NULL);
+    bool DeselectRanges(const wxRangeIntSelection &ranges, wxRangeIntSelection *changed = NULL);
+
+    // Set operations with a sorted array of non overlapping ranges, or another
+    //   selection, in one linear merge, returns true if anything was done
+    //   if either is a bitmap they're merged a chunk at a time as bitmaps
+    bool Union(const wxArrayRangeInt &ranges);
+    bool Intersect(const wxArrayRangeInt &ranges);
+    bool Subtract(const wxArrayRangeInt &ranges);
+    bool Union(const wxRangeIntSelection &ranges);
+    bool Intersect(const wxRangeIntSelection &ranges);
+    bool Subtract(const wxRangeIntSelection &ranges);
+    // Select everything within the bounds that isn't selected and deselect the rest
+    bool Invert(const wxRangeInt &bounds);
+
     // Set the min and max bounds of the ranges, returns true if anything was done
     bool BoundRanges(const wxRangeInt &range);
 
+    // Store the selection as a wxBitmapIntSelection if it's fragmented into
+    //   many small ranges, or as the ranges if not, done by the bulk operations
+    void Optimize();
+    inline bool IsBitmap() const {return m_useBitmap;}
+
     // operators
-    inline const wxRangeInt& operator[](int index) const {return GetRange(index);}
+    inline wxRangeInt operator[](int index) const {return GetRange(index);}
 
     wxRangeIntSelection& operator = (const wxRangeIntSelection& other) {Copy(other); return *this;}
 
 protected:
-    wxArrayRangeInt m_ranges;
+    // Get the ranges, made from the bitmap if it's used
+    const wxArrayRangeInt& Ranges() const;
+    // Stop using the bitmap, before operations done on the ranges
+    void UseRanges();
+    // The set operations, with the ranges or the bitmap if it's not NULL
+    bool Combine(const wxArrayRangeInt &ranges, const wxBitmapIntSelection *bitmap,
+                 wxBitmapIntSelection::Op op, wxRangeIntSelection *changed);
+
+    mutable wxArrayRangeInt m_ranges; // a cache of the bitmap if it's used
+    mutable bool m_rangesValid = true;
+    wxBitmapIntSelection m_bitmap;
+    bool m_useBitmap = false;
 };
 
 #endif
@@ -11,11 +11,15 @@
 #include <math.h>
 #include <float.h>
 #include <limits.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include "wx/panel.h"
 #include "wx/scrolbar.h"
 #include "wx/event.h"
 #include "wx/timer.h"
+#include "wx/stopwatch.h"
 #include "wx/dcmemory.h"
 #include "wx/msgdlg.h"
 #include "wx/geometry.h"
@@ -41,6 +45,18 @@
 
 #define MAX_PLOT_ZOOMS 5
 #define TIC_STEPS 3
+#define FRAME_INTERVAL 16 // ms between frames, see wxPlotCtrl::SetFrameInterval
+#define MOTION_PROBE_INTERVAL 1000 // ms between resending unhandled motion events
+
+// progressive drawing, see wxPlotCtrl::SetProgressiveDraw
+#define PREVIEW_POINTS_PER_PIXEL 4     // points per pixel column in the preview
+#define PREVIEW_MIN_POINTS       8192  // curves with fewer are never decimated
+#define REFINE_CHUNK_SIZE        32768 // points drawn between checking the time
+#define REFINE_TIME_SLICE        10    // ms of refining per idle event
+
+#define SELECT_BLOCK_SIZE 1024 // points tested at once when selecting a rectangle or predicate
+#define SELECT_PARALLEL_MIN 1048576 // points per thread for SelectWhere
+#define VALUES_PARALLEL_MIN 16384   // curves per thread for GetValuesAtX
 
 std::numeric_limits<wxDouble> wxDouble_limits;
 const wxDouble wxPlot_MIN_DBL   = wxDouble_limits.min()*10;
@@ -70,6 +86,389 @@ inline bool wxPlotRect2DDoubleContains(double x, double y, const wxRect2DDouble
     return ((x>=rect.m_x) && (y>=rect.m_y) && (x<=rect.GetRight()) && (y<=rect.GetBottom()));
 }
 
+// add the runs of pass[i] != 0 for the points first to first+count-1 to runs,
+//   run_start is the start of a run still going on, -1 if none
+static void AppendSelectionRuns(const unsigned char *pass, int first, int count,
+                                int &run_start, wxRangeIntSelection &runs)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (pass[i] && (run_start < 0))
+            run_start = first + i;
+        else if (!pass[i] && (run_start >= 0))
+        {
+            runs.SelectRange(wxRangeInt(run_start, first + i - 1));
+            run_start = -1;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// wxPlotDataPredicate
+//----------------------------------------------------------------------------
+
+bool wxPlotDataPredicate::GetXRange(double &min, double &max) const
+{
+    if (value_ != Value::X)
+        return false;
+
+    switch (test_)
+    {
+        case Test::ABOVE  : min = min_;  max = wxDouble_limits.infinity(); return true;
+        case Test::BELOW  : min = -wxDouble_limits.infinity(); max = max_; return true;
+        case Test::INSIDE : min = min_;  max = max_; return true;
+        default : break;
+    }
+
+    return false;
+}
+
+void wxPlotDataPredicate::Evaluate(const double *xs, const double *ys, int count,
+                                   unsigned char *pass) const
+{
+    int i;
+
+    if (test_ == Test::FUNCTION)
+    {
+        for (i = 0; i < count; i++)
+            pass[i] = function_ && function_(xs[i], ys[i]);
+
+        return;
+    }
+
+    const double *vs = ((value_ == Value::X) || (value_ == Value::ABS_X)) ? xs : ys;
+    const bool abs_value = (value_ == Value::ABS_X) || (value_ == Value::ABS_Y);
+    const double min = min_, max = max_;
+
+    // a loop for each test without branches so the compiler can vectorize
+    //   them, comparisons with NaN are all false
+    switch (test_)
+    {
+        case Test::ABOVE :
+            for (i = 0; i < count; i++)
+                pass[i] = (abs_value ? fabs(vs[i]) : vs[i]) > min;
+            break;
+        case Test::BELOW :
+            for (i = 0; i < count; i++)
+                pass[i] = (abs_value ? fabs(vs[i]) : vs[i]) < max;
+            break;
+        case Test::INSIDE :
+            for (i = 0; i < count; i++)
+            {
+                double v = abs_value ? fabs(vs[i]) : vs[i];
+                pass[i] = (v >= min) & (v <= max);
+            }
+            break;
+        case Test::OUTSIDE :
+            for (i = 0; i < count; i++)
+            {
+                double v = abs_value ? fabs(vs[i]) : vs[i];
+                pass[i] = (v < min) | (v > max);
+            }
+            break;
+        case Test::IS_NAN :
+            for (i = 0; i < count; i++)
+                pass[i] = vs[i] != vs[i];
+            break;
+        default :
+            memset(pass, 0, count);
+            break;
+    }
+}
+
+//----------------------------------------------------------------------------
+// wxPlotCurveTree
+//----------------------------------------------------------------------------
+
+// the rect of a curve in the tree, an empty or NaN side never excludes it
+static wxRect2DDouble CurveTreeRect(const wxRect2DDouble &rect)
+{
+    wxRect2DDouble r(rect);
+    if (!((r.m_width > 0) && wxFinite(r.m_x) && wxFinite(r.m_width)))
+    {
+        r.m_x = -wxPlot_MAX_DBL;
+        r.m_width = wxPlot_MAX_RANGE;
+    }
+    if (!((r.m_height > 0) && wxFinite(r.m_y) && wxFinite(r.m_height)))
+    {
+        r.m_y = -wxPlot_MAX_DBL;
+        r.m_height = wxPlot_MAX_RANGE;
+    }
+    return r;
+}
+
+static inline wxRect2DDouble CurveTreeUnion(const wxRect2DDouble &a, const wxRect2DDouble &b)
+{
+    double left   = wxMin(a.m_x, b.m_x);
+    double bottom = wxMin(a.m_y, b.m_y);
+    return wxRect2DDouble(left, bottom, wxMax(a.GetRight(),  b.GetRight())  - left,
+                                        wxMax(a.GetBottom(), b.GetBottom()) - bottom);
+}
+
+// the cost of a node, the half perimeter works for flat rects too
+static inline double CurveTreeCost(const wxRect2DDouble &r)
+{
+    return r.m_width + r.m_height;
+}
+
+static inline bool CurveTreeIntersects(const wxRect2DDouble &a, const wxRect2DDouble &b)
+{
+    return (a.m_x <= b.GetRight()) && (b.m_x <= a.GetRight()) &&
+           (a.m_y <= b.GetBottom()) && (b.m_y <= a.GetBottom());
+}
+
+void wxPlotCurveTree::Clear()
+{
+    nodes_.clear();
+    freeNodes_.clear();
+    leaves_.clear();
+    root_ = -1;
+}
+
+int wxPlotCurveTree::NewNode()
+{
+    if (freeNodes_.empty())
+    {
+        nodes_.push_back(Node());
+        return int(nodes_.size()) - 1;
+    }
+
+    int node = freeNodes_.back();
+    freeNodes_.pop_back();
+    return node;
+}
+
+void wxPlotCurveTree::Add(const wxRect2DDouble &rect, unsigned long version)
+{
+    int leaf = NewNode();
+    Node &node = nodes_[leaf];
+    node.rect_   = CurveTreeRect(rect);
+    node.version_ = version;
+    node.parent_ = node.child1_ = node.child2_ = -1;
+    node.index_  = int(leaves_.size());
+    node.height_ = 0;
+
+    leaves_.push_back(leaf);
+    InsertLeaf(leaf);
+}
+
+void wxPlotCurveTree::Remove(int index)
+{
+    wxCHECK_RET((index >= 0) && (index < GetCount()), wxT("Invalid curve index"));
+
+    RemoveLeaf(leaves_[index]);
+    freeNodes_.push_back(leaves_[index]);
+    leaves_.erase(leaves_.begin() + index);
+
+    for (size_t n = index; n < leaves_.size(); n++)
+        nodes_[leaves_[n]].index_--;
+}
+
+bool wxPlotCurveTree::Update(int index, const wxRect2DDouble &rect, unsigned long version)
+{
+    wxCHECK_MSG((index >= 0) && (index < GetCount()), false, wxT("Invalid curve index"));
+
+    int leaf = leaves_[index];
+    nodes_[leaf].version_ = version;
+    wxRect2DDouble r(CurveTreeRect(rect));
+    if (r == nodes_[leaf].rect_)
+        return false;
+
+    RemoveLeaf(leaf);
+    nodes_[leaf].rect_ = r;
+    InsertLeaf(leaf);
+    return true;
+}
+
+void wxPlotCurveTree::InsertLeaf(int leaf)
+{
+    if (root_ < 0)
+    {
+        root_ = leaf;
+        nodes_[leaf].parent_ = -1;
+        return;
+    }
+
+    // walk down to the cheapest sibling for it
+    const wxRect2DDouble rect(nodes_[leaf].rect_);
+    int sibling = root_;
+    while (nodes_[sibling].child1_ >= 0)
+    {
+        const Node &node = nodes_[sibling];
+        double combined    = CurveTreeCost(CurveTreeUnion(node.rect_, rect));
+        double cost        = 2*combined;                  // a new parent here
+        double inheritance = 2*(combined - CurveTreeCost(node.rect_)); // going down
+
+        double childCost[2];
+        int children[2] = {node.child1_, node.child2_};
+        for (int c = 0; c < 2; c++)
+        {
+            const Node &child = nodes_[children[c]];
+            childCost[c] = CurveTreeCost(CurveTreeUnion(child.rect_, rect)) + inheritance;
+            if (child.child1_ >= 0)
+                childCost[c] -= CurveTreeCost(child.rect_);
+        }
+
+        if ((cost < childCost[0]) && (cost < childCost[1]))
+            break;
+
+        sibling = (childCost[0] <= childCost[1]) ? children[0] : children[1];
+    }
+
+    // a new parent of the sibling and leaf
+    int oldParent = nodes_[sibling].parent_;
+    int parent = NewNode();
+    Node &node   = nodes_[parent];
+    node.parent_ = oldParent;
+    node.child1_ = sibling;
+    node.child2_ = leaf;
+    node.index_  = -1;
+    nodes_[sibling].parent_ = parent;
+    nodes_[leaf].parent_ = parent;
+
+    if (oldParent < 0)
+        root_ = parent;
+    else if (nodes_[oldParent].child1_ == sibling)
+        nodes_[oldParent].child1_ = parent;
+    else
+        nodes_[oldParent].child2_ = parent;
+
+    Refit(parent);
+
+    // sorted inserts make a list, start over when it's far from log2(n)
+    int levels = 0;
+    for (size_t n = leaves_.size(); n > 0; n >>= 1)
+        levels++;
+    if (nodes_[root_].height_ > 2*levels + 4)
+        Rebuild();
+}
+
+void wxPlotCurveTree::RemoveLeaf(int leaf)
+{
+    if (leaf == root_)
+    {
+        root_ = -1;
+        return;
+    }
+
+    // the sibling takes the place of the parent
+    int parent = nodes_[leaf].parent_;
+    int grandParent = nodes_[parent].parent_;
+    int sibling = (nodes_[parent].child1_ == leaf) ? nodes_[parent].child2_ : nodes_[parent].child1_;
+
+    nodes_[sibling].parent_ = grandParent;
+    if (grandParent < 0)
+        root_ = sibling;
+    else
+    {
+        if (nodes_[grandParent].child1_ == parent)
+            nodes_[grandParent].child1_ = sibling;
+        else
+            nodes_[grandParent].child2_ = sibling;
+
+        Refit(grandParent);
+    }
+
+    freeNodes_.push_back(parent);
+}
+
+void wxPlotCurveTree::Refit(int node)
+{
+    for (; node >= 0; node = nodes_[node].parent_)
+    {
+        Node &n = nodes_[node];
+        const Node &c1 = nodes_[n.child1_], &c2 = nodes_[n.child2_];
+        n.rect_   = CurveTreeUnion(c1.rect_, c2.rect_);
+        n.height_ = 1 + wxMax(c1.height_, c2.height_);
+    }
+}
+
+int wxPlotCurveTree::Build(int *leaves, int count, int parent)
+{
+    if (count == 1)
+    {
+        nodes_[leaves[0]].parent_ = parent;
+        return leaves[0];
+    }
+
+    // split at the median of the centers along the longer side of their extent
+    double minX = wxPlot_MAX_RANGE, maxX = -wxPlot_MAX_RANGE;
+    double minY = wxPlot_MAX_RANGE, maxY = -wxPlot_MAX_RANGE;
+    int n;
+    for (n = 0; n < count; n++)
+    {
+        const wxRect2DDouble &r = nodes_[leaves[n]].rect_;
+        double x = r.m_x + r.m_width/2, y = r.m_y + r.m_height/2;
+        minX = wxMin(minX, x); maxX = wxMax(maxX, x);
+        minY = wxMin(minY, y); maxY = wxMax(maxY, y);
+    }
+
+    const bool split_x = (maxX - minX) >= (maxY - minY);
+    const std::vector<Node> &nodes = nodes_;
+    std::nth_element(leaves, leaves + count/2, leaves + count,
+        [&nodes, split_x](int a, int b)
+        {
+            const wxRect2DDouble &ra = nodes[a].rect_, &rb = nodes[b].rect_;
+            return split_x ? (ra.m_x + ra.m_width/2  < rb.m_x + rb.m_width/2)
+                           : (ra.m_y + ra.m_height/2 < rb.m_y + rb.m_height/2);
+        });
+
+    int node = NewNode();
+    nodes_[node].parent_ = parent;
+    nodes_[node].index_  = -1;
+    int child1 = Build(leaves, count/2, node);
+    int child2 = Build(leaves + count/2, count - count/2, node);
+
+    Node &n2 = nodes_[node];
+    n2.child1_ = child1;
+    n2.child2_ = child2;
+    n2.rect_   = CurveTreeUnion(nodes_[child1].rect_, nodes_[child2].rect_);
+    n2.height_ = 1 + wxMax(nodes_[child1].height_, nodes_[child2].height_);
+    return node;
+}
+
+void wxPlotCurveTree::Rebuild()
+{
+    // keep the leaves, drop the rest
+    std::vector<Node> nodes(leaves_.size());
+    std::vector<int> leaves(leaves_.size());
+    for (size_t n = 0; n < leaves_.size(); n++)
+    {
+        nodes[n] = nodes_[leaves_[n]];
+        leaves_[n] = leaves[n] = int(n);
+    }
+
+    nodes_.swap(nodes);
+    nodes_.reserve(2*leaves.size());
+    freeNodes_.clear();
+    root_ = leaves.empty() ? -1 : Build(&leaves[0], int(leaves.size()), -1);
+}
+
+void wxPlotCurveTree::Query(const wxRect2DDouble &rect, std::vector<int> &indexes) const
+{
+    indexes.clear();
+    if (root_ < 0)
+        return;
+
+    std::vector<int> stack(1, root_);
+    while (!stack.empty())
+    {
+        const Node &node = nodes_[stack.back()];
+        stack.pop_back();
+
+        if (!CurveTreeIntersects(node.rect_, rect))
+            continue;
+
+        if (node.child1_ < 0)
+            indexes.push_back(node.index_);
+        else
+        {
+            stack.push_back(node.child1_);
+            stack.push_back(node.child2_);
+        }
+    }
+}
+
 //----------------------------------------------------------------------------
 // Event types
 //----------------------------------------------------------------------------
@@ -187,6 +586,9 @@ namespace {
     int ID_AREA_TIMER = wxNewId();
     int ID_XAXIS_TIMER = wxNewId();
     int ID_YAXIS_TIMER = wxNewId();
+    int ID_FRAME_TIMER = wxNewId();
+    int ID_MOTION_TIMER = wxNewId();
+    int ID_RENDER_THREAD = wxNewId();
 // Redraw parts or all of the windows
 enum RedrawNeed
 {
@@ -287,24 +689,67 @@ void wxPlotCtrl::Area::OnPaint(wxPaintEvent&)
 
     if ((redrawNeed & REDRAW_BLOCKER) != 0)
         return;
-/*
-    wxRegionIterator upd(GetUpdateRegion());
-    while (upd)
-    {
-        //printf("Region %d %d %d %d \n", upd.GetX(), upd.GetY(), upd.GetWidth(), upd.GetHeight()); fflush(stdout);
-        Paint(&dc, upd.GetRect());
-        upd++;
-    }
-*/
 
     if (redrawNeed & REDRAW_PLOT)
     {
-        CreateBitmap(host_->GetPlotAreaRect());
-        host_->SetRedrawNeeds(redrawNeed & ~REDRAW_PLOT);
+        wxRect clientRect(host_->GetPlotAreaRect());
+        wxRegion &dirtyRegion = host_->dirtyRegion_;
+
+        if (!bitmap_.Ok() || (bitmap_.GetWidth()  != clientRect.width) ||
+                             (bitmap_.GetHeight() != clientRect.height))
+        {
+            CreateBitmap(clientRect);
+            dirtyRegion.Clear();
+        }
+        else if (host_->GetAsyncDraw() || host_->areaPreview_)
+        {
+            // show the last complete frame, the next one is drawn by the render
+            //   thread or in idle time
+            host_->StartAsyncFrame();
+        }
+        else
+        {
+            // only rebuild the dirty parts that are about to be shown
+            wxRegion region(dirtyRegion);
+            region.Intersect(GetUpdateRegion());
+
+            // each rect redraws all the curves, don't let it fragment too much
+            int count = 0;
+            for (wxRegionIterator upd(region); upd; ++upd)
+                count++;
+
+            if (count > 4)
+                CreateBitmap(region.GetBox());
+            else
+            {
+                for (wxRegionIterator upd(region); upd; ++upd)
+                    CreateBitmap(upd.GetRect());
+            }
+
+            dirtyRegion.Subtract(region);
+        }
+
+        if (dirtyRegion.IsEmpty())
+            host_->SetRedrawNeeds(redrawNeed & ~REDRAW_PLOT);
     }
 
+    // blit only what is being painted, the transient graphics go on top
+    //   so moving them just needs their old and new rects refreshed
     if (bitmap_.Ok())
-        dc.DrawBitmap(bitmap_, 0, 0, false);
+    {
+        wxMemoryDC mdc;
+        mdc.SelectObjectAsSource(bitmap_);
+
+        for (wxRegionIterator upd(GetUpdateRegion()); upd; ++upd)
+        {
+            wxRect rect(upd.GetRect());
+            dc.Blit(rect.x, rect.y, rect.width, rect.height, &mdc, rect.x, rect.y);
+        }
+
+        mdc.SelectObject(wxNullBitmap);
+    }
+
+    host_->DrawCurveCursor(&dc);
 
     if (host_->GetCrossHairCursor() && host_->GetPlotAreaRect().Contains(lastMousePosition_))
         host_->DrawCrosshairCursor(&dc, lastMousePosition_);
@@ -444,6 +889,9 @@ BEGIN_EVENT_TABLE(wxPlotCtrl, wxWindow)
     EVT_IDLE             (wxPlotCtrl::OnIdle)
     EVT_MOUSE_EVENTS     (wxPlotCtrl::OnMouse)
     EVT_TIMER            (wxID_ANY, wxPlotCtrl::OnTimer)
+#if wxUSE_THREADS
+    EVT_THREAD           (wxID_ANY, wxPlotCtrl::OnRenderThread)
+#endif
 
     EVT_TEXT_ENTER       (wxID_ANY, wxPlotCtrl::OnTextEnter)
 END_EVENT_TABLE()
@@ -478,6 +926,7 @@ wxPlotCtrl::wxPlotCtrl():
     drawSymbols_(true),
     drawLines_(true),
     drawSpline_(false),
+    drawDensity_(false),
     drawGrid_(true),
     drawTicks_(false),
     fitOnNewCurve_(true),
@@ -529,6 +978,39 @@ wxPlotCtrl::wxPlotCtrl():
     redrawNeed_(REDRAW_BLOCKER),
     batchCount_(0),
 
+    historyCacheSize_(0),
+    styleVersion_(0),
+
+    redrawSpanCurve_(wxNOT_FOUND),
+    markersVersion_(0),
+    markersLayerVersion_(0),
+    markersLayerValid_(false),
+    useAreaLayers_(true),
+    frameTimer_(nullptr),
+    frameInterval_(FRAME_INTERVAL),
+    frameNeed_(REDRAW_NONE),
+    frameShift_(0, 0),
+    frameScrollBars_(false),
+    motionTimer_(nullptr),
+    motionInterval_(0),
+    lastMotionTime_(0),
+    skipUnhandledMotion_(false),
+    motionUnhandled_(false),
+    progressiveDraw_(false),
+    asyncDraw_(false),
+    zoomPreview_(true),
+    areaPreview_(false),
+    bitmapView_(0, 0, 0, 0),
+    bitmapZoom_(1, 1),
+    lastAreaDrawTime_(0),
+    refinePos_(-1),
+    refineIndex_(0),
+    pickBuffer_(nullptr),
+    refinePickBuffer_(nullptr),
+    renderThread_(nullptr),
+    renderGeneration_(1),
+    renderRequested_(0),
+
     axisFontSize_(6, 12),
     leftAxisTextWidth_(60),
     areaBorderWidth_(1),
@@ -646,12 +1128,24 @@ bool wxPlotCtrl::Create(wxWindow *parent, wxWindowID win_id,
 
 wxPlotCtrl::~wxPlotCtrl()
 {
+#if wxUSE_THREADS
+    if (renderThread_)
+    {
+        renderThread_->Stop();
+        delete renderThread_;
+    }
+#endif
+
     delete areaDrawer_;
     delete bottomAxisDrawer_;
     delete leftAxisDrawer_;
     delete keyDrawer_;
     delete dataCurveDrawer_;
     delete markerDrawer_;
+    delete frameTimer_;
+    delete motionTimer_;
+    delete pickBuffer_;
+    delete refinePickBuffer_;
 }
 
 void wxPlotCtrl::OnPaint(wxPaintEvent &WXUNUSED(event))
@@ -674,7 +1168,7 @@ void wxPlotCtrl::DrawActiveBitmap(wxDC *dc)
         int top  = yAxisScrollbar_->GetRect().GetBottom();
         wxRect rect(left, top, size.x - left, size.y - top);
         // clear background
-        dc->SetBrush(wxBrush(GetBackgroundColour(), wxBRUSHSTYLE_SOLID));
+        dc->SetBrush(*wxTheBrushList->FindOrCreateBrush(GetBackgroundColour(), wxBRUSHSTYLE_SOLID));
         dc->SetPen(*wxTRANSPARENT_PEN);
         dc->DrawRectangle(rect);
         // center the bitmap
@@ -912,6 +1406,8 @@ void wxPlotCtrl::OnEraseBackground(wxEraseEvent &event)
 void wxPlotCtrl::OnIdle(wxIdleEvent &event)
 {
     CheckFocus();
+    if (RefineAreaBitmap())
+        event.RequestMore();
     event.Skip();
 }
 
@@ -1017,8 +1513,8 @@ void wxPlotCtrl::SetCursorColour(const wxColour &colour)
 {
     wxCHECK_RET(colour.Ok(), wxT("invalid colour"));
     cursorMarker_.GetPen().SetColour(colour);
-    wxClientDC dc(area_);
-    DrawCurveCursor(&dc);
+    if (IsCursorValid())
+        RefreshAreaOverlay(GetMarkerClientRect(cursorMarker_));
 }
 wxColour wxPlotCtrl::GetCursorColour() const
 {
@@ -1148,18 +1644,18 @@ void wxPlotCtrl::SetKeyFont(const wxFont &font)
 {
     wxCHECK_RET(font.Ok(), wxT("invalid font"));
     keyDrawer_->SetFont(font);
-    Redraw(REDRAW_PLOT);
+    RedrawKey();
 }
 void wxPlotCtrl::SetKeyColour(const wxColour &colour)
 {
     wxCHECK_RET(colour.Ok(), wxT("invalid colour"));
     keyDrawer_->SetFontColour(colour);
-    Redraw(REDRAW_PLOT);
+    RedrawKey();
 }
 void wxPlotCtrl::SetShowKey(bool show)
 {
     showKey_ = show;
-    Redraw(REDRAW_PLOT);
+    RedrawKey();
 }
 
 // ------------------------------------------------------------------------
@@ -1305,7 +1801,7 @@ void wxPlotCtrl::SetKeyPosition(const wxPoint &pos, bool stayInside)
 {
     keyDrawer_->keyPosition_ = pos;
     keyDrawer_->keyInside_ = stayInside;
-    Redraw(REDRAW_PLOT);
+    RedrawKey();
 }
 
 void wxPlotCtrl::CreateKeyString()
@@ -1397,6 +1893,7 @@ bool wxPlotCtrl::DeleteCurve(int n, bool sendEvent)
         ClearSelectedRanges(-1, sendEvent);
         dataSelections_.Clear();
         curves_.Clear();
+        curveTree_.Clear();
     }
     else
     {
@@ -1408,6 +1905,8 @@ bool wxPlotCtrl::DeleteCurve(int n, bool sendEvent)
         ClearSelectedRanges(n, sendEvent);
         dataSelections_.RemoveAt(n);
         curves_.RemoveAt(n);
+        if (n < curveTree_.GetCount())
+            curveTree_.Remove(n);
     }
 
     int oldActiveIndex = activeIndex_;
@@ -1506,16 +2005,24 @@ int wxPlotCtrl::GetActiveIndex() const
 int wxPlotCtrl::AddMarker(const wxPlotMarker &marker)
 {
     plotMarkers_.Add(marker);
+    markersVersion_++;
+    RedrawRect(GetMarkerClientRect(marker));
     return plotMarkers_.GetCount() - 1;
 }
 void wxPlotCtrl::RemoveMarker(int marker)
 {
     wxCHECK_RET((marker >= 0) && (marker < (int)plotMarkers_.GetCount()), wxT("Invalid marker number"));
+    RedrawRect(GetMarkerClientRect(plotMarkers_[marker]));
     plotMarkers_.RemoveAt(marker);
+    markersVersion_++;
 }
 void wxPlotCtrl::ClearMarkers()
 {
+    for (size_t n = 0; n < plotMarkers_.GetCount(); n++)
+        RedrawRect(GetMarkerClientRect(plotMarkers_[n]));
+
     plotMarkers_.Clear();
+    markersVersion_++;
 }
 wxPlotMarker wxPlotCtrl::GetMarker(int marker) const
 {
@@ -1525,6 +2032,8 @@ wxPlotMarker wxPlotCtrl::GetMarker(int marker) const
 }
 wxArrayPlotMarker &wxPlotCtrl::GetMarkerArray()
 {
+    // the caller may change the markers through the reference
+    markersVersion_++;
     return plotMarkers_;
 }
 
@@ -1535,6 +2044,8 @@ wxArrayPlotMarker &wxPlotCtrl::GetMarkerArray()
 void wxPlotCtrl::InvalidateCursor(bool sendEvent)
 {
     bool changed = cursorCurve_ >= 0;
+    if (changed)
+        RefreshAreaOverlay(GetMarkerClientRect(cursorMarker_));
     cursorCurve_ = -1;
     cursorIndex_ = -1;
     cursorMarker_.SetPlotPosition(wxPoint2DDouble(0, 0));
@@ -1624,8 +2135,7 @@ bool wxPlotCtrl::SetCursorDataIndex(int curveIndex, int cursorIndex, bool sendEv
             return false;
     }
 
-    int oldCursorCurve = cursorCurve_;
-    int oldCursorIndex = cursorIndex_;
+    wxRect oldCursorRect(IsCursorValid() ? GetMarkerClientRect(cursorMarker_) : wxRect());
     cursorMarker_.SetPlotPosition(cursorPt);
     cursorCurve_ = curveIndex;
     cursorIndex_ = cursorIndex;
@@ -1639,13 +2149,9 @@ bool wxPlotCtrl::SetCursorDataIndex(int curveIndex, int cursorIndex, bool sendEv
         DoSendEvent(cursorEvent);
     }
 
-    if ((activeIndex_ == oldCursorCurve) && (activeIndex_ == cursorCurve_))
-    {
-        RedrawCurve(curveIndex, oldCursorIndex, oldCursorIndex);
-        RedrawCurve(curveIndex, cursorIndex_, cursorIndex_);
-    }
-    else
-        Redraw(REDRAW_PLOT);
+    // the cursor is drawn over the area bitmap, just show it moved
+    RefreshAreaOverlay(oldCursorRect);
+    RefreshAreaOverlay(GetMarkerClientRect(cursorMarker_));
 
     return true;
 }
@@ -1672,6 +2178,7 @@ bool wxPlotCtrl::SetCursorXPoint(int curveIndex, double x, bool sendEvent)
             return false;
     }
 
+    wxRect oldCursorRect(IsCursorValid() ? GetMarkerClientRect(cursorMarker_) : wxRect());
     cursorMarker_.SetPlotPosition(cursorPt);
     cursorCurve_ = curveIndex;
     cursorIndex_ = -1;
@@ -1684,7 +2191,9 @@ bool wxPlotCtrl::SetCursorXPoint(int curveIndex, double x, bool sendEvent)
         DoSendEvent(cursorEvent);
     }
 
-    Redraw(REDRAW_PLOT);
+    // the cursor is drawn over the area bitmap, just show it moved
+    RefreshAreaOverlay(oldCursorRect);
+    RefreshAreaOverlay(GetMarkerClientRect(cursorMarker_));
     return true;
 }
 
@@ -1846,62 +2355,40 @@ bool wxPlotCtrl::DoSelectRectangle(int curveIndex, const wxRect2DDouble &rect,
 
 
         int i, count = plotData->GetCount();
-        int first_sel = -1;
-        double *x_data = plotData->GetXData();
-        double *y_data = plotData->GetYData();
-
-        int min = plotData->GetCount() - 1, max = 0;
+        const double *x_data = plotData->GetXData();
+        const double *y_data = plotData->GetYData();
 
-        wxRangeIntSelection ranges;
-
-        for (i=0; i<count; i++)
+        // only the points between the x limits need testing if x is ordered
+        const bool test_x = !is_y_range, test_y = !is_x_range;
+        int start = 0, end = count;
+        if (test_x && plotData->GetIsXOrdered())
         {
-            if ((is_x_range && *x_data >= xRangeMin && *x_data <= xRangeMax) ||
-                (is_y_range && *y_data >= yRangeMin && *y_data <= yRangeMax) ||
-                (!is_x_range && !is_y_range && wxPlotRect2DDoubleContains(*x_data, *y_data, rect)))
-            {
-                if (select)
-                {
-                    if (dataSelections_[curveIndex].SelectRange(wxRangeInt(i,i)))
-                    {
-                        ranges.SelectRange(wxRangeInt(i,i));
-                        done = true;
-                    }
-                }
-                else
-                {
-                    if (dataSelections_[curveIndex].DeselectRange(wxRangeInt(i,i)))
-                    {
-                        ranges.SelectRange(wxRangeInt(i,i));
-                        done = true;
-                    }
-                }
-
-                min = wxMin(min, i);
-                max = wxMin(max, i);
-
-                if (done && (first_sel == -1))
-                    first_sel = i;
-            }
-
-            x_data++;
-            y_data++;
+            start = std::lower_bound(x_data, x_data + count, xRangeMin) - x_data;
+            end   = std::upper_bound(x_data + start, x_data + count, xRangeMax) - x_data;
         }
 
-        if (done && (min <= max))
-            RedrawCurve(curveIndex, min, max);
+        // collect the runs of points inside in one pass
+        wxRangeIntSelection runs;
+        unsigned char inside[SELECT_BLOCK_SIZE];
+        int run_start = -1;
 
-        if (sendEvent && done)
+        for (int block = start; block < end; block += SELECT_BLOCK_SIZE)
         {
-            wxPlotCtrlSelEvent event(wxEVT_PLOTCTRL_RANGE_SEL_CHANGED, GetId(), this);
-            event.SetCurve(GetCurve(curveIndex), curveIndex);
-            event.SetDataSelectionRange(wxRangeInt(first_sel, first_sel), select);
-            event.SetDataSelections(ranges);
-            DoSendEvent(event);
+            int block_count = wxMin(SELECT_BLOCK_SIZE, end - block);
+            const double *xs = &x_data[block], *ys = &y_data[block];
+
+            // no branches so the compiler can vectorize it
+            for (i = 0; i < block_count; i++)
+                inside[i] = (!test_x | ((xs[i] >= xRangeMin) & (xs[i] <= xRangeMax))) &
+                            (!test_y | ((ys[i] >= yRangeMin) & (ys[i] <= yRangeMax)));
+
+            AppendSelectionRuns(inside, block, block_count, run_start, runs);
         }
 
-        return done;
+        if (run_start >= 0)
+            runs.SelectRange(wxRangeInt(run_start, end - 1));
 
+        return DoSelectDataRanges(curveIndex, runs, select, sendEvent);
     }
     else
     {
@@ -1940,6 +2427,10 @@ bool wxPlotCtrl::DoSelectDataRange(int curveIndex, const wxRangeInt &range,
     else
         done = dataSelections_[curveIndex].DeselectRange(range);
 
+    // many single points selected one at a time fragment the selection
+    if (done)
+        dataSelections_[curveIndex].Optimize();
+
     if (sendEvent && done)
     {
         wxPlotCtrlSelEvent event(wxEVT_PLOTCTRL_RANGE_SEL_CHANGED, GetId(), this);
@@ -1955,38 +2446,160 @@ bool wxPlotCtrl::DoSelectDataRange(int curveIndex, const wxRangeInt &range,
     return done;
 }
 
-int wxPlotCtrl::GetSelectedRangeCount(int curveIndex) const
+bool wxPlotCtrl::DoSelectWhere(int curveIndex, const wxPlotDataPredicate &predicate,
+                               bool select, bool sendEvent)
 {
-    wxCHECK_MSG(CurveIndexOk(curveIndex), 0, wxT("invalid plotcurve index"));
+    wxCHECK_MSG((curveIndex >= -1) && (curveIndex<int(curves_.GetCount())),
+                false, wxT("invalid plotcurve index"));
 
-    return dataSelections_[curveIndex].GetCount();
-}
-bool wxPlotCtrl::SelectRectangle(int curveIndex, const wxRect2DDouble &rect, bool sendEvent)
-{
-    return DoSelectRectangle(curveIndex, rect, true, sendEvent);
-}
-bool wxPlotCtrl::DeselectRectangle(int curveIndex, const wxRect2DDouble &rect, bool sendEvent)
-{
-    return DoSelectRectangle(curveIndex, rect, false, sendEvent);
-}
-bool wxPlotCtrl::SelectXRange(int curveIndex, double rangeMin, double rangeMax, bool sendEvent)
-{
-    return DoSelectRectangle(curveIndex, wxRect2DDouble(rangeMin, -wxPlot_MAX_DBL, rangeMax - rangeMin, wxPlot_MAX_RANGE), true, sendEvent);
-}
-bool wxPlotCtrl::DeselectXRange(int curveIndex, double rangeMin, double rangeMax, bool sendEvent)
-{
-    return DoSelectRectangle(curveIndex, wxRect2DDouble(rangeMin, -wxPlot_MAX_DBL, rangeMax - rangeMin, wxPlot_MAX_RANGE), false, sendEvent);
-}
-bool wxPlotCtrl::SelectYRange(int curveIndex, double rangeMin, double rangeMax, bool sendEvent)
-{
-    return DoSelectRectangle(curveIndex, wxRect2DDouble(-wxPlot_MAX_DBL, rangeMin, wxPlot_MAX_RANGE, rangeMax - rangeMin), true, sendEvent);
-}
-bool wxPlotCtrl::DeselectYRange(int curveIndex, double rangeMin, double rangeMax, bool sendEvent)
-{
-    return DoSelectRectangle(curveIndex, wxRect2DDouble(-wxPlot_MAX_DBL, rangeMin, wxPlot_MAX_RANGE, rangeMax - rangeMin), false, sendEvent);
-}
-bool wxPlotCtrl::SelectDataRange(int curveIndex, const wxRangeInt &range, bool sendEvent)
-{
+    if (selectionType_ == SelectionType::NONE)
+        return false;
+
+    // Run this code for all the curves if curve == -1 then exit
+    if (curveIndex == -1)
+    {
+        bool done = false;
+        size_t n, curve_count = curves_.GetCount();
+
+        for (n = 0; n < curve_count; n++)
+        {
+            if (GetCurve(n))
+                done |= DoSelectWhere(n, predicate, select, sendEvent);
+        }
+
+        return done;
+    }
+
+    wxPlotData *plotData = GetCurve(curveIndex);
+    wxCHECK_MSG(plotData && plotData->Ok(), false, wxT("Invalid data curve"));
+
+    // check the selection type and clear previous selections if necessary
+    if (select)
+        UpdateSelectionState(curveIndex, sendEvent);
+
+    int count = plotData->GetCount();
+    const double *x_data = plotData->GetXData();
+    const double *y_data = plotData->GetYData();
+
+    // only the points between the x limits need testing if x is ordered
+    int start = 0, end = count;
+    double xMin, xMax;
+    if (plotData->GetIsXOrdered() && predicate.GetXRange(xMin, xMax))
+    {
+        start = std::lower_bound(x_data, x_data + count, xMin) - x_data;
+        end   = std::upper_bound(x_data + start, x_data + count, xMax) - x_data;
+    }
+
+    // test a block at a time and collect the runs of points that pass, large
+    //   curves are split into chunks for threads that each collect their own
+    //   runs, user functions may not be thread safe so they're all done here
+    int points = end - start;
+    size_t chunks = 1;
+    if ((predicate.GetTest() != wxPlotDataPredicate::Test::FUNCTION) && (points > SELECT_PARALLEL_MIN))
+        chunks = (points + SELECT_PARALLEL_MIN - 1)/SELECT_PARALLEL_MIN;
+    std::vector<wxRangeIntSelection> chunkRuns(chunks);
+
+    wxPlotParallelFor(chunks, 1, [&](size_t first, size_t last)
+    {
+        unsigned char pass[SELECT_BLOCK_SIZE];
+
+        for (size_t c = first; c < last; c++)
+        {
+            int chunk_start = start + int(c*points/chunks);
+            int chunk_end = start + int((c + 1)*points/chunks);
+            int run_start = -1;
+
+            for (int block = chunk_start; block < chunk_end; block += SELECT_BLOCK_SIZE)
+            {
+                int block_count = wxMin(SELECT_BLOCK_SIZE, chunk_end - block);
+                predicate.Evaluate(&x_data[block], &y_data[block], block_count, pass);
+                AppendSelectionRuns(pass, block, block_count, run_start, chunkRuns[c]);
+            }
+
+            if (run_start >= 0)
+                chunkRuns[c].SelectRange(wxRangeInt(run_start, chunk_end - 1));
+        }
+    });
+
+    // runs meeting at the ends of the chunks are joined
+    wxRangeIntSelection runs;
+    for (size_t c = 0; c < chunks; c++)
+        runs.Union(chunkRuns[c]);
+
+    return DoSelectDataRanges(curveIndex, runs, select, sendEvent);
+}
+
+bool wxPlotCtrl::DoSelectDataRanges(int curveIndex, const wxRangeIntSelection &runs,
+                                    bool select, bool sendEvent)
+{
+    wxCHECK_MSG(CurveIndexOk(curveIndex), false, wxT("invalid plotcurve index"));
+
+    // merge them into the selection at once, ranges gets what changed
+    wxRangeIntSelection ranges;
+    bool done;
+    if (select)
+        done = dataSelections_[curveIndex].SelectRanges(runs, &ranges);
+    else
+        done = dataSelections_[curveIndex].DeselectRanges(runs, &ranges);
+
+    if (!done)
+        return false;
+
+    wxRangeInt changed(ranges.GetBoundingRange());
+    RedrawCurve(curveIndex, changed.m_min, changed.m_max);
+
+    if (sendEvent)
+    {
+        wxPlotCtrlSelEvent event(wxEVT_PLOTCTRL_RANGE_SEL_CHANGED, GetId(), this);
+        event.SetCurve(GetCurve(curveIndex), curveIndex);
+        event.SetDataSelectionRange(wxRangeInt(changed.m_min, changed.m_min), select);
+        event.SetDataSelections(ranges);
+        DoSendEvent(event);
+    }
+
+    return true;
+}
+
+int wxPlotCtrl::GetSelectedRangeCount(int curveIndex) const
+{
+    wxCHECK_MSG(CurveIndexOk(curveIndex), 0, wxT("invalid plotcurve index"));
+
+    return dataSelections_[curveIndex].GetCount();
+}
+bool wxPlotCtrl::SelectRectangle(int curveIndex, const wxRect2DDouble &rect, bool sendEvent)
+{
+    return DoSelectRectangle(curveIndex, rect, true, sendEvent);
+}
+bool wxPlotCtrl::DeselectRectangle(int curveIndex, const wxRect2DDouble &rect, bool sendEvent)
+{
+    return DoSelectRectangle(curveIndex, rect, false, sendEvent);
+}
+bool wxPlotCtrl::SelectXRange(int curveIndex, double rangeMin, double rangeMax, bool sendEvent)
+{
+    return DoSelectRectangle(curveIndex, wxRect2DDouble(rangeMin, -wxPlot_MAX_DBL, rangeMax - rangeMin, wxPlot_MAX_RANGE), true, sendEvent);
+}
+bool wxPlotCtrl::DeselectXRange(int curveIndex, double rangeMin, double rangeMax, bool sendEvent)
+{
+    return DoSelectRectangle(curveIndex, wxRect2DDouble(rangeMin, -wxPlot_MAX_DBL, rangeMax - rangeMin, wxPlot_MAX_RANGE), false, sendEvent);
+}
+bool wxPlotCtrl::SelectYRange(int curveIndex, double rangeMin, double rangeMax, bool sendEvent)
+{
+    return DoSelectRectangle(curveIndex, wxRect2DDouble(-wxPlot_MAX_DBL, rangeMin, wxPlot_MAX_RANGE, rangeMax - rangeMin), true, sendEvent);
+}
+bool wxPlotCtrl::DeselectYRange(int curveIndex, double rangeMin, double rangeMax, bool sendEvent)
+{
+    return DoSelectRectangle(curveIndex, wxRect2DDouble(-wxPlot_MAX_DBL, rangeMin, wxPlot_MAX_RANGE, rangeMax - rangeMin), false, sendEvent);
+}
+bool wxPlotCtrl::SelectWhere(int curveIndex, const wxPlotDataPredicate &predicate, bool sendEvent)
+{
+    return DoSelectWhere(curveIndex, predicate, true, sendEvent);
+}
+bool wxPlotCtrl::DeselectWhere(int curveIndex, const wxPlotDataPredicate &predicate, bool sendEvent)
+{
+    return DoSelectWhere(curveIndex, predicate, false, sendEvent);
+}
+bool wxPlotCtrl::SelectDataRange(int curveIndex, const wxRangeInt &range, bool sendEvent)
+{
     return DoSelectDataRange(curveIndex, range, true, sendEvent);
 }
 bool wxPlotCtrl::DeselectDataRange(int curveIndex, const wxRangeInt &range, bool sendEvent)
@@ -2028,67 +2641,144 @@ bool wxPlotCtrl::ClearSelectedRanges(int curveIndex, bool sendEvent)
 // ------------------------------------------------------------------------
 // Get/Set origin, size, and Zoom in/out of view, set scaling, size...
 // ------------------------------------------------------------------------
-/*
+bool wxPlotCtrl::ShiftOrigin(int dx, int dy, bool sendEvent)
+{
+    if ((dx == 0) && (dy == 0)) return true;
 
-// FIXME - can't shift the bitmap due to off by one errors in ClipLineToRect
+    double origin_x = viewRect_.GetLeft() - dx/zoom_.m_x;
+    double origin_y = viewRect_.GetTop()  + dy/zoom_.m_y;
 
-void wxPlotCtrl::ShiftOrigin(int dx, int dy, bool sendEvent)
-{
-    if ((dx == 0) && (dy == 0)) return;
+    // shifts are collected until the next frame, they must stay on the bitmap
+    int shift_x = frameShift_.x + dx, shift_y = frameShift_.y + dy;
+    if (batchCount_ ||
+        (abs(shift_x) >= areaClientRect_.width) || (abs(shift_y) >= areaClientRect_.height))
+    {
+        return SetOrigin(origin_x, origin_y, sendEvent);
+    }
+
+    if (!IsFinite(origin_x, wxT("X origin is not finite"))) return false;
+    if (!IsFinite(origin_y, wxT("Y origin is not finite"))) return false;
 
     if (sendEvent)
     {
         wxPlotCtrlEvent event(wxEVT_PLOTCTRL_VIEW_CHANGING, GetId(), this);
         event.SetCurve(activeCurve_, activeIndex_);
-        if (DoSendEvent(event)) return;
+        event.SetPosition(origin_x, origin_y);
+        if (!DoSendEvent(event))
+            return false;
     }
 
+    viewRect_.m_x = origin_x;
+    viewRect_.m_y = origin_y;
+    refinePos_ = -1;
+    renderGeneration_++;
+    CorrectAxisTicks(dx != 0, dy != 0);
+
+    frameShift_ = wxPoint(shift_x, shift_y);
+    frameNeed_ |= (dx != 0 ? REDRAW_BOTTOM_AXIS : 0) | (dy != 0 ? REDRAW_LEFT_AXIS : 0);
+    frameScrollBars_ = true;
+    ScheduleFrame();
+
+    if (sendEvent)
     {
-        wxBitmap tempBitmap(areaClientRect_.width, areaClientRect_.height);
-        wxMemoryDC mdc;
-        mdc.SelectObject(tempBitmap);
-        mdc.DrawBitmap(m_area->m_bitmap, dx, dy, false);
-        mdc.SelectObject(wxNullBitmap);
-        m_area->m_bitmap = tempBitmap;
+        wxPlotCtrlEvent event(wxEVT_PLOTCTRL_VIEW_CHANGED, GetId(), this);
+        event.SetCurve(activeCurve_, activeIndex_);
+        event.SetPosition(viewRect_.m_x, viewRect_.m_y);
+        DoSendEvent(event);
     }
-    wxRect rx, ry;
 
-    viewRect_.m_x -= dx / zoom_.m_x;
-    viewRect_.m_y += dy / zoom_.m_y;
+    return true;
+}
 
-    if (dx != 0)
+void wxPlotCtrl::ShiftArea(int dx, int dy, int axisNeed)
+{
+    wxPoint2DDouble oldZoom = zoom_;
+    double origin_x = viewRect_.m_x, origin_y = viewRect_.m_y;
+
+    // recalculate the ticks, their correction may nudge the view slightly
+    DoRedraw(axisNeed);
+
+    // only a bitmap of the right size can be shifted, else redraw everything
+    wxBitmap &bitmap = area_->bitmap_;
+    if (!bitmap.Ok() ||
+        (bitmap.GetWidth()  != areaClientRect_.width) ||
+        (bitmap.GetHeight() != areaClientRect_.height) ||
+        (abs(dx) >= areaClientRect_.width) || (abs(dy) >= areaClientRect_.height) ||
+        (zoom_ != oldZoom) ||
+        (fabs(viewRect_.m_x - origin_x)*zoom_.m_x >= 0.5) ||
+        (fabs(viewRect_.m_y - origin_y)*zoom_.m_y >= 0.5))
     {
-        rx = wxRect((dx>0 ? -5 : areaClientRect_.width+dx-5), 0, labs(dx)+10, areaClientRect_.height);
-        RedrawXAxis(false);
+        DoRedraw(REDRAW_PLOT);
+        return;
     }
-    if (dy != 0)
+
+    wxRect keyRect(keyDrawer_->GetLastKeyRect());
+
+    if (!area_->shiftBitmap_.Ok() ||
+        (area_->shiftBitmap_.GetWidth()  != areaClientRect_.width) ||
+        (area_->shiftBitmap_.GetHeight() != areaClientRect_.height))
     {
-        ry = wxRect(0, (dy>0 ? -5 : areaClientRect_.height+dy-5), areaClientRect_.width, labs(dy)+10);
-        RedrawYAxis(false);
+        area_->shiftBitmap_.Create(areaClientRect_.width, areaClientRect_.height);
     }
 
-    printf("Shift %d %d rx %d %d %d %d, ry %d %d %d %d\n", dx, dy, rx.x, rx.y, rx.width, rx.height, ry.x, ry.y, ry.width, ry.height); fflush(stdout);
+    wxMemoryDC mdc;
+    mdc.SelectObject(area_->shiftBitmap_);
+    mdc.DrawBitmap(bitmap, dx, dy, false);
+    mdc.SelectObject(wxNullBitmap);
+
+    wxBitmap temp(bitmap);
+    bitmap = area_->shiftBitmap_;
+    area_->shiftBitmap_ = temp;
 
-    if (rx.width > 0) m_area->CreateBitmap(rx);
-        //m_area->Refresh(false, &rx);
-    if (ry.height > 0) m_area->CreateBitmap(ry);
-        //m_area->Refresh(false, &ry);
+    // the pick buffer moves with it if it was drawn for the view shifted
+    if (pickBuffer_)
+    {
+        const wxRect2DDouble &pickView = pickBuffer_->view_;
+        if ((pickBuffer_->size_ == areaClientRect_.GetSize()) && (pickBuffer_->zoom_ == zoom_) &&
+            (fabs((pickView.m_x - viewRect_.m_x)*zoom_.m_x - dx) < 0.5) &&
+            (fabs((viewRect_.m_y - pickView.m_y)*zoom_.m_y - dy) < 0.5))
+        {
+            pickBuffer_->Shift(dx, dy, viewRect_);
+        }
+        else
+            pickBuffer_->Invalidate();
+    }
 
+    // parts that were out of date moved along with the rest
+    redrawSpanCurve_ = wxNOT_FOUND;
+    if (!dirtyRegion_.IsEmpty())
     {
-        wxClientDC cdc(m_area);
-        cdc.DrawBitmap(m_area->m_bitmap, 0, 0);
+        dirtyRegion_.Offset(dx, dy);
+        dirtyRegion_.Intersect(GetPlotAreaRect());
     }
 
-    adjustScrollBars();
+    // the border moved with the plot, redraw a little more than exposed
+    int margin = 5 + areaBorderWidth_;
 
-    if (sendEvent)
+    if (dx != 0)
+        dirtyRegion_.Union(wxRect((dx > 0 ? 0 : areaClientRect_.width + dx) - margin, 0,
+                                  abs(dx) + 2*margin, areaClientRect_.height));
+    if (dy != 0)
+        dirtyRegion_.Union(wxRect(0, (dy > 0 ? 0 : areaClientRect_.height + dy) - margin,
+                                  areaClientRect_.width, abs(dy) + 2*margin));
+
+    // the key stays put, so erase its shifted copy and draw it again
+    if (!keyRect.IsEmpty())
     {
-        wxPlotCtrlEvent event(wxEVT_PLOTCTRL_VIEW_CHANGED, GetId(), this);
-        event.SetCurve(activeCurve_, activeIndex_);
-        DoSendEvent(event);
+        dirtyRegion_.Union(wxRect(keyRect).Offset(dx, dy).Inflate(2));
+        dirtyRegion_.Union(wxRect(keyRect).Inflate(2));
     }
+
+    dirtyRegion_.Intersect(GetPlotAreaRect());
+    redrawNeed_ |= REDRAW_PLOT;
+    refinePos_ = -1;
+    renderGeneration_++;
+    bitmapView_ = viewRect_;
+    bitmapZoom_ = zoom_;
+
+    // everything moved, so the whole window is blit again
+    area_->Refresh(false);
 }
-*/
 
 void wxPlotCtrl::SetSelectionType(SelectionType type)
 {
@@ -2156,6 +2846,7 @@ bool wxPlotCtrl::SetZoom(const wxRect &window, bool sendEvent)
     double zoom_x = zoom_.m_x * double(areaClientRect_.width) /(window.GetWidth());
     double zoom_y = zoom_.m_y * double(areaClientRect_.height)/(window.GetHeight());
 
+    CacheHistoryFrame();
     bool ok = SetZoom(zoom_x, zoom_y, origin_x, origin_y, sendEvent);
     if (ok)
         AddHistoryView();
@@ -2215,27 +2906,49 @@ bool wxPlotCtrl::SetZoom(double zoom_x, double zoom_y,
         viewRect_.m_y = origin_y;
         viewRect_.m_width  = view_width;
         viewRect_.m_height = view_height;
+
+        if (!batchCount_)
+            CorrectAxisTicks(x_changed, y_changed);
+
+        PreviewAreaView();
     }
 
     // redraw even if unchanged since we expect that it should be different
-    Redraw(REDRAW_PLOT |
-           (x_changed ? REDRAW_BOTTOM_AXIS : 0) |
-           (y_changed ? REDRAW_LEFT_AXIS   : 0));
-
     if (!batchCount_)
-        AdjustScrollBars();
+    {
+        frameScrollBars_ = true;
+        RedrawView(REDRAW_PLOT |
+                   (x_changed ? REDRAW_BOTTOM_AXIS : 0) |
+                   (y_changed ? REDRAW_LEFT_AXIS   : 0));
+    }
 
     if (sendEvent && (x_changed || y_changed))
     {
         wxPlotCtrlEvent event(wxEVT_PLOTCTRL_VIEW_CHANGED, GetId(), this);
         event.SetCurve(activeCurve_, activeIndex_);
-        event.SetPosition(origin_x, origin_y);
+        event.SetPosition(viewRect_.m_x, viewRect_.m_y);
         DoSendEvent(event);
     }
 
     return true;
 }
 
+void wxPlotCtrl::CorrectAxisTicks(bool correctX, bool correctY)
+{
+    // the view is final when it's set, only the tick positions and the
+    //   drawing wait for the next frame
+    if (correctX && bottomAxisTicks_.correct_)
+    {
+        AutoCalcXAxisTicks();
+        CorrectXAxisTicks();
+    }
+    if (correctY && leftAxisTicks_.correct_)
+    {
+        AutoCalcYAxisTicks();
+        CorrectYAxisTicks();
+    }
+}
+
 void wxPlotCtrl::SetFixAspectRatio(bool fix, double ratio)
 {
     wxCHECK_RET(ratio > 0, wxT("Invalid aspect ratio"));
@@ -2334,6 +3047,8 @@ void wxPlotCtrl::NextHistoryView(bool foward, bool sendEvent)
 {
     int count = historyViews_.GetCount();
 
+    CacheHistoryFrame();
+
     // try to set it to the "current" history view
     if ((historyViewsIndex_ > -1) && (historyViewsIndex_ < count))
     {
@@ -2359,6 +3074,132 @@ void wxPlotCtrl::NextHistoryView(bool foward, bool sendEvent)
         else
             SetZoom(-1, -1, 0, 0, sendEvent);
     }
+
+    RestoreHistoryFrame();
+}
+
+int wxPlotCtrl::GetHistoryCacheSize() const
+{
+    return historyCacheSize_;
+}
+
+void wxPlotCtrl::SetHistoryCacheSize(int count)
+{
+    historyCacheSize_ = wxMax(count, 0);
+    if (int(historyFrames_.size()) > historyCacheSize_)
+        historyFrames_.resize(historyCacheSize_);
+}
+
+void wxPlotCtrl::CacheHistoryFrame()
+{
+    if (historyCacheSize_ <= 0) return;
+
+    // only a complete and exact frame of the current view is worth keeping
+    wxBitmap &areaBitmap = area_->bitmap_;
+    if (batchCount_ || IsFramePending() || (refinePos_ >= 0) || areaPreview_ ||
+        ((redrawNeed_ & (REDRAW_WHOLEPLOT|REDRAW_BLOCKER)) != 0) ||
+        !areaBitmap.Ok() || !bottomAxis_->bitmap_.Ok() || !leftAxis_->bitmap_.Ok() ||
+        (areaBitmap.GetWidth()  != areaClientRect_.width) ||
+        (areaBitmap.GetHeight() != areaClientRect_.height) ||
+        !(bitmapView_ == viewRect_))
+    {
+        return;
+    }
+
+    // the area and axis bitmaps are drawn into later, keep copies
+    HistoryFrame frame;
+    frame.viewRect_ = viewRect_;
+    frame.zoom_ = zoom_;
+    frame.size_ = areaClientRect_.GetSize();
+    frame.styleVersion_ = styleVersion_;
+    GetCurveVersions(frame.curveVersions_);
+    frame.area_ = areaBitmap.GetSubBitmap(areaClientRect_);
+    frame.bottomAxis_ = bottomAxis_->bitmap_.GetSubBitmap(
+        wxRect(0, 0, bottomAxis_->bitmap_.GetWidth(), bottomAxis_->bitmap_.GetHeight()));
+    frame.leftAxis_ = leftAxis_->bitmap_.GetSubBitmap(
+        wxRect(0, 0, leftAxis_->bitmap_.GetWidth(), leftAxis_->bitmap_.GetHeight()));
+
+    // replace the entry of the same view, or the least recently used one
+    std::vector<HistoryFrame>::iterator it = historyFrames_.begin();
+    for (; it != historyFrames_.end(); ++it)
+    {
+        if ((it->viewRect_ == frame.viewRect_) && (it->size_ == frame.size_))
+            break;
+    }
+    if (it != historyFrames_.end())
+        historyFrames_.erase(it);
+    else if (int(historyFrames_.size()) >= historyCacheSize_)
+        historyFrames_.pop_back();
+
+    historyFrames_.insert(historyFrames_.begin(), frame);
+}
+
+void wxPlotCtrl::GetCurveVersions(std::vector<unsigned long> &versions) const
+{
+    int i, count = curves_.GetCount();
+    versions.resize(2*count);
+    for (i = 0; i < count; i++)
+    {
+        versions[2*i]   = curves_[i].GetDataVersion();
+        versions[2*i+1] = curves_[i].GetPenVersion();
+    }
+}
+
+bool wxPlotCtrl::RestoreHistoryFrame()
+{
+    if (historyFrames_.empty() || batchCount_) return false;
+
+    // the cached frame replaces the pending one, the tick positions of the
+    //   view are still calculated by it
+    FlushFrame();
+
+    // SetViewRect goes through the zoom, allow for the rounding
+    auto sameView = [&](const HistoryFrame &frame)
+    {
+        return (fabs(frame.viewRect_.m_x - viewRect_.m_x)*zoom_.m_x < 0.01) &&
+               (fabs(frame.viewRect_.m_y - viewRect_.m_y)*zoom_.m_y < 0.01) &&
+               (fabs(frame.zoom_.m_x - zoom_.m_x) <= 1e-9*zoom_.m_x) &&
+               (fabs(frame.zoom_.m_y - zoom_.m_y) <= 1e-9*zoom_.m_y);
+    };
+
+    std::vector<unsigned long> curveVersions;
+    GetCurveVersions(curveVersions);
+
+    std::vector<HistoryFrame>::iterator it = historyFrames_.begin();
+    for (; it != historyFrames_.end(); ++it)
+    {
+        if ((it->styleVersion_ == styleVersion_) && (it->curveVersions_ == curveVersions) &&
+            (it->size_ == areaClientRect_.GetSize()) &&
+            (it->bottomAxis_.GetSize() == bottomAxis_->GetClientSize()) &&
+            (it->leftAxis_.GetSize() == leftAxis_->GetClientSize()) && sameView(*it))
+        {
+            break;
+        }
+    }
+    if (it == historyFrames_.end()) return false;
+
+    // move it to the front, it's the most recently used now
+    HistoryFrame frame(*it);
+    historyFrames_.erase(it);
+    historyFrames_.insert(historyFrames_.begin(), frame);
+
+    // show copies, the cached ones mustn't be drawn into
+    area_->bitmap_ = frame.area_.GetSubBitmap(wxRect(wxPoint(0, 0), frame.size_));
+    bottomAxis_->bitmap_ = frame.bottomAxis_.GetSubBitmap(wxRect(wxPoint(0, 0), frame.bottomAxis_.GetSize()));
+    leftAxis_->bitmap_ = frame.leftAxis_.GetSubBitmap(wxRect(wxPoint(0, 0), frame.leftAxis_.GetSize()));
+
+    dirtyRegion_.Clear();
+    redrawNeed_ &= ~REDRAW_WHOLEPLOT;
+    refinePos_ = -1;
+    renderGeneration_++;
+    areaPreview_ = false;
+    bitmapView_ = viewRect_;
+    bitmapZoom_ = zoom_;
+
+    area_->Refresh(false);
+    bottomAxis_->Refresh(false);
+    leftAxis_->Refresh(false);
+    return true;
 }
 
 int wxPlotCtrl::GetHistoryViewCount() const
@@ -2443,10 +3284,9 @@ void wxPlotCtrl::SetAreaMouseMarker(MarkerType type)
     if (type == areaMouseMarker_)
         return;
 
-    wxClientDC dc(area_);
-    DrawMouseMarker(&dc, areaMouseMarker_, area_->mouseDragRectangle_);
+    RefreshMouseMarker(areaMouseMarker_, area_->mouseDragRectangle_);
     areaMouseMarker_ = type;
-    DrawMouseMarker(&dc, areaMouseMarker_, area_->mouseDragRectangle_);
+    RefreshMouseMarker(areaMouseMarker_, area_->mouseDragRectangle_);
 }
 
 wxPlotCtrl::MarkerType wxPlotCtrl::GetAreaMouseMarker() const
@@ -2476,8 +3316,8 @@ bool wxPlotCtrl::GetCrossHairCursor() const
 void wxPlotCtrl::SetCrossHairCursor(bool useCrosshairCursor)
 {
     crosshairCursor_ = useCrosshairCursor;
+    RefreshCrosshairCursor(area_->lastMousePosition_);
     area_->lastMousePosition_ = wxPoint(-1,-1);
-    Redraw(REDRAW_PLOT);
 }
 bool wxPlotCtrl::GetDrawSymbols() const
 {
@@ -2506,6 +3346,61 @@ void wxPlotCtrl::SetDrawSpline(bool drawSpline)
     drawSpline_ = drawSpline;
     Redraw(REDRAW_PLOT);
 }
+bool wxPlotCtrl::GetDrawDensity() const
+{
+    return drawDensity_;
+}
+void wxPlotCtrl::SetDrawDensity(bool drawDensity)
+{
+    drawDensity_ = drawDensity;
+    Redraw(REDRAW_PLOT);
+}
+bool wxPlotCtrl::GetUsePickBuffer() const
+{
+    return pickBuffer_ != nullptr;
+}
+void wxPlotCtrl::SetUsePickBuffer(bool usePickBuffer)
+{
+    if (usePickBuffer == GetUsePickBuffer()) return;
+
+    delete pickBuffer_;
+    delete refinePickBuffer_;
+    pickBuffer_ = refinePickBuffer_ = nullptr;
+
+    if (usePickBuffer)
+    {
+        pickBuffer_ = new wxPlotPickBuffer;
+        refinePickBuffer_ = new wxPlotPickBuffer;
+    }
+
+    Redraw(REDRAW_PLOT);
+}
+bool wxPlotCtrl::GetProgressiveDraw() const
+{
+    return progressiveDraw_;
+}
+void wxPlotCtrl::SetProgressiveDraw(bool progressive)
+{
+    progressiveDraw_ = progressive;
+    Redraw(REDRAW_PLOT);
+}
+bool wxPlotCtrl::GetZoomPreview() const
+{
+    return zoomPreview_;
+}
+void wxPlotCtrl::SetZoomPreview(bool preview)
+{
+    zoomPreview_ = preview;
+}
+bool wxPlotCtrl::GetAsyncDraw() const
+{
+    return asyncDraw_;
+}
+void wxPlotCtrl::SetAsyncDraw(bool async)
+{
+    asyncDraw_ = async;
+    Redraw(REDRAW_PLOT);
+}
 bool wxPlotCtrl::GetDrawGrid() const
 {
     return drawGrid_;
@@ -2664,18 +3559,23 @@ void wxPlotCtrl::DoSize(const wxRect &boundingRect, bool setWindowSizes)
     zoom_.m_x = zoom_x;
     zoom_.m_y = zoom_y;
 
+    if (!batchCount_)
+        CorrectAxisTicks(true, true);
+
     wxPlotCtrlEvent event(wxEVT_PLOTCTRL_VIEW_CHANGED, GetId(), this);
     event.SetCurve(activeCurve_, activeIndex_);
     DoSendEvent(event);
 
     redrawNeed_ = 0;
-    Redraw(REDRAW_WHOLEPLOT);
+    RedrawView(REDRAW_WHOLEPLOT);
 }
 
 void wxPlotCtrl::CalcBoundingPlotRect()
 {
     int i, count = curves_.GetCount();
 
+    UpdateCurveTree();
+
     if (count > 0)
     {
         bool valid_rect = false;
@@ -2750,92 +3650,775 @@ void wxPlotCtrl::Redraw(int need)
 {
     if (batchCount_) return;
 
+    styleVersion_++;
+    RedrawView(need);
+}
+
+void wxPlotCtrl::RedrawView(int need)
+{
+    if (batchCount_) return;
+
+    frameNeed_ |= need;
+    ScheduleFrame();
+}
+
+int wxPlotCtrl::GetFrameInterval() const
+{
+    return frameInterval_;
+}
+
+void wxPlotCtrl::SetFrameInterval(int ms)
+{
+    frameInterval_ = wxMax(ms, 0);
+    if (frameInterval_ == 0)
+        FlushFrame();
+}
+
+void wxPlotCtrl::ScheduleFrame()
+{
+    if (frameInterval_ <= 0)
+    {
+        FlushFrame();
+        return;
+    }
+
+    if (!frameTimer_)
+        frameTimer_ = new wxTimer(this, ID_FRAME_TIMER);
+
+    if (!frameTimer_->IsRunning())
+        frameTimer_->Start(frameInterval_, true); // one shot timer
+}
+
+bool wxPlotCtrl::IsFramePending() const
+{
+    return (frameNeed_ != REDRAW_NONE) || (frameShift_ != wxPoint(0, 0)) || frameScrollBars_;
+}
+
+void wxPlotCtrl::FlushFrame()
+{
+    if (frameTimer_ && frameTimer_->IsRunning())
+        frameTimer_->Stop();
+
+    if (!IsFramePending()) return;
+
+    int need = frameNeed_;
+    wxPoint shift = frameShift_;
+    bool scrollBars = frameScrollBars_;
+    frameNeed_ = REDRAW_NONE;
+    frameShift_ = wxPoint(0, 0);
+    frameScrollBars_ = false;
+
+    // a shift is pointless if everything is redrawn anyway
+    if ((shift != wxPoint(0, 0)) && ((need & REDRAW_PLOT) == 0))
+    {
+        ShiftArea(shift.x, shift.y, need & (REDRAW_BOTTOM_AXIS | REDRAW_LEFT_AXIS));
+        need &= ~(REDRAW_BOTTOM_AXIS | REDRAW_LEFT_AXIS);
+    }
+
+    if (need != REDRAW_NONE)
+        DoRedraw(need);
+    if (scrollBars)
+        AdjustScrollBars();
+}
+
+void wxPlotCtrl::DoRedraw(int need)
+{
+    if (batchCount_) return;
+
     if (need & REDRAW_BOTTOM_AXIS)
     {
         redrawNeed_ |= REDRAW_BOTTOM_AXIS;
         AutoCalcXAxisTicks();
-        if (bottomAxisTicks_.correct_)
-            CorrectXAxisTicks();
         CalcXAxisTickPositions();
     }
     if (need & REDRAW_LEFT_AXIS)
     {
         redrawNeed_ |= REDRAW_LEFT_AXIS;
         AutoCalcYAxisTicks();
-        if (leftAxisTicks_.correct_)
-            CorrectYAxisTicks();
         CalcYAxisTickPositions();
     }
 
     if (need & REDRAW_PLOT)
     {
         redrawNeed_ |= REDRAW_PLOT;
+        dirtyRegion_ = wxRegion(GetPlotAreaRect());
+        redrawSpanCurve_ = wxNOT_FOUND;
+        refinePos_ = -1; // the paint starts it again
+        renderGeneration_++;
         area_->Refresh(false);
     }
 
-    if (need & REDRAW_BOTTOM_AXIS)
-        bottomAxis_->Refresh(false);
-    if (need & REDRAW_LEFT_AXIS)
-        leftAxis_->Refresh(false);
+    if (need & REDRAW_BOTTOM_AXIS)
+        bottomAxis_->Refresh(false);
+    if (need & REDRAW_LEFT_AXIS)
+        leftAxis_->Refresh(false);
+
+    if (need & REDRAW_WINDOW)
+        Refresh();
+}
+
+void wxPlotCtrl::RedrawRect(const wxRect &rect)
+{
+    if (batchCount_) return;
+
+    // the rect is in the current view, the bitmap must be too
+    if (frameShift_ != wxPoint(0, 0))
+        FlushFrame();
+
+    styleVersion_++;
+
+    wxRect dirtyRect(rect);
+    dirtyRect.Intersect(GetPlotAreaRect());
+    if (dirtyRect.IsEmpty()) return;
+
+    redrawNeed_ |= REDRAW_PLOT;
+    dirtyRegion_.Union(dirtyRect);
+    redrawSpanCurve_ = wxNOT_FOUND;
+    refinePos_ = -1;
+    renderGeneration_++;
+    area_->Refresh(false, &dirtyRect);
+}
+
+wxRect wxPlotCtrl::GetMarkerClientRect(const wxPlotMarker &marker) const
+{
+    wxCHECK_MSG(marker.Ok(), wxRect(), wxT("Invalid marker"));
+
+    // keep the corners just outside of the window so the math can't overflow
+    wxRect2DDouble r(marker.GetPlotRect());
+    auto clampX = [&](double x)
+        { return wxMax(-1.0, wxMin(double(areaClientRect_.width + 1), zoom_.m_x*(x - viewRect_.GetLeft()))); };
+    auto clampY = [&](double y)
+        { return wxMax(-1.0, wxMin(double(areaClientRect_.height + 1), areaClientRect_.height - zoom_.m_y*(y - viewRect_.GetTop()))); };
+
+    double x0 = clampX(r.m_x), x1 = clampX(r.GetRight());
+    double y0 = clampY(r.m_y), y1 = clampY(r.GetBottom());
+    if (!wxFinite(x0) || !wxFinite(x1) || !wxFinite(y0) || !wxFinite(y1))
+        return wxRect();
+
+    wxRect rect(int(floor(wxMin(x0, x1))), int(floor(wxMin(y0, y1))),
+                int(ceil(fabs(x1 - x0))) + 1, int(ceil(fabs(y1 - y0))) + 1);
+
+    // shapes and bitmaps of a fixed pixel size around the position
+    wxSize size(marker.GetSize());
+    if (marker.GetMarkerType() == wxPLOTMARKER_BITMAP)
+        size = marker.GetBitmap().Ok() ? marker.GetBitmap().GetSize() : wxSize(0, 0);
+    if ((size.x > 0) && (size.y > 0))
+        rect.Union(wxRect(int(x0) - size.x, int(y0) - size.y, 2*size.x + 1, 2*size.y + 1));
+
+    if (r.m_width < 0)
+    {
+        rect.x = 0;
+        rect.width = areaClientRect_.width;
+    }
+    if (r.m_height < 0)
+    {
+        rect.y = 0;
+        rect.height = areaClientRect_.height;
+    }
+
+    int penWidth = marker.GetPen().Ok() ? marker.GetPen().GetWidth() : 1;
+    return rect.Inflate(penWidth + 2);
+}
+
+void wxPlotCtrl::RedrawKey()
+{
+    RedrawRect(keyDrawer_->GetLastKeyRect());
+
+    if (GetShowKey() && !keyString_.IsEmpty())
+    {
+        wxClientDC dc(area_);
+        keyDrawer_->SetDCRect(wxRect(wxPoint(0, 0), GetPlotAreaRect().GetSize()));
+        RedrawRect(keyDrawer_->GetKeyRect(&dc, keyString_));
+    }
+}
+
+void wxPlotCtrl::DrawAreaWindow(wxDC *dc, const wxRect &rect)
+{
+    wxCHECK_RET(dc, wxT("invalid dc"));
+
+    // GTK doesn't like invalid parameters
+    wxRect refreshRect = rect;
+    wxRect clientRect(GetPlotAreaRect());
+    refreshRect.Intersect(clientRect);
+
+    if ((refreshRect.width == 0) || (refreshRect.height == 0)) return;
+
+    wxStopWatch stopWatch;
+
+    if (useAreaLayers_)
+    {
+        // the background, grid and markers rarely change, copy them
+        wxMemoryDC mdc;
+        mdc.SelectObjectAsSource(UpdateAreaLayers());
+        dc->Blit(refreshRect.x, refreshRect.y, refreshRect.width, refreshRect.height,
+                 &mdc, refreshRect.x, refreshRect.y);
+        mdc.SelectObject(wxNullBitmap);
+    }
+    else
+    {
+        dc->SetClippingRegion(refreshRect);
+        DrawAreaBackground(dc, refreshRect);
+        DrawMarkers(dc, refreshRect);
+        dc->DestroyClippingRegion();
+    }
+
+    // keep the curves, cursor, key and border within the refreshed rect
+    dc->SetClippingRegion(refreshRect);
+
+    // the pick buffer is drawn with the area bitmap, a part of it only if
+    //   the rest is of the same view
+    if (useAreaLayers_ && pickBuffer_)
+    {
+        if (refreshRect == clientRect)
+            pickBuffer_->Reset(clientRect.GetSize(), viewRect_, zoom_);
+        else if (IsPickBufferValid())
+            pickBuffer_->Clear(refreshRect);
+        else
+            pickBuffer_->Invalidate();
+
+        if (IsPickBufferValid())
+            dataCurveDrawer_->SetPickBuffer(pickBuffer_);
+    }
+
+    // only the points changed by RedrawCurve are drawn of that curve, with
+    //   the ones in the rect, if it's ordered. Any segment of an unordered
+    //   one may cross the rect, so all of it is drawn clipped to the rect.
+    bool spanOnly = (redrawSpanCurve_ >= 0) && (refreshRect != clientRect);
+
+    // large curves are decimated, the full detail is drawn in idle time
+    bool refine = false;
+    auto drawCurve = [&](wxPlotData *curve, int index)
+    {
+        int start, end;
+        GetCurveSpanInRect(curve, refreshRect, start, end);
+
+        if (spanOnly && (index == redrawSpanCurve_) && curve->GetIsXOrdered())
+        {
+            int count = curve->GetCount();
+            start = wxMin(start, wxMin(redrawSpan_.m_min, count - 1));
+            end = wxMax(end, wxMin(redrawSpan_.m_max + 1, count));
+
+            DrawDataCurvePart(dc, curve, index, refreshRect, start, end, 1);
+            return;
+        }
+
+        int stride = GetPreviewStride(curve);
+        if (stride > 1)
+        {
+            DrawDataCurvePart(dc, curve, index, refreshRect, start, end, stride);
+            refine = true;
+        }
+        else if ((start == 0) && (end == (int)curve->GetCount()))
+            DrawDataCurve(dc, curve, index, refreshRect);
+        else
+            DrawDataCurvePart(dc, curve, index, refreshRect, start, end, 1);
+    };
+
+    int i;
+    wxPlotData *curve;
+    wxPlotData *activeCurve = GetActiveCurve();
+    for (i = 0; i < GetCurveCount(); i++)
+    {
+        curve = GetCurve(i);
+
+        if (curve != activeCurve)
+            drawCurve(curve, i);
+    }
+    // active curve is drawn on top
+    if (activeCurve)
+        drawCurve(activeCurve, GetActiveIndex());
+
+    dataCurveDrawer_->SetPickBuffer(NULL);
+
+    DrawAreaForeground(dc, clientRect);
+    dc->DestroyClippingRegion();
+
+    // whatever was refined so far is out of date, start over
+    if (useAreaLayers_)
+    {
+        refinePos_ = refine ? 0 : -1;
+        refineIndex_ = 0;
+
+        if (refreshRect == clientRect)
+        {
+            bitmapView_ = viewRect_;
+            bitmapZoom_ = zoom_;
+            areaPreview_ = false;
+            lastAreaDrawTime_ = stopWatch.Time();
+        }
+    }
+}
+
+void wxPlotCtrl::DrawAreaForeground(wxDC *dc, const wxRect &rect)
+{
+    wxCHECK_RET(dc, wxT("invalid dc"));
+
+    // on screen the cursor is drawn over the bitmap in Area::OnPaint
+    if (!useAreaLayers_)
+        DrawCurveCursor(dc);
+    DrawKey(dc);
+
+    // refresh border
+    dc->SetBrush(*wxTRANSPARENT_BRUSH);
+    if (gridType_ != GridType::SmithChart)
+        dc->SetPen(*wxThePenList->FindOrCreatePen(GetBorderColour(), areaBorderWidth_, wxPENSTYLE_SOLID));
+    else
+        dc->SetPen(*wxThePenList->FindOrCreatePen(GetBackgroundColour(), areaBorderWidth_, wxPENSTYLE_SOLID));
+    dc->DrawRectangle(rect);
+
+    dc->SetPen(wxNullPen);
+    dc->SetBrush(wxNullBrush);
+}
+
+int wxPlotCtrl::GetPreviewStride(wxPlotData *curve) const
+{
+    if (!progressiveDraw_ || !useAreaLayers_ || !curve) return 1;
+
+    // a few points per pixel column are enough to show the shape
+    int points = wxMax(PREVIEW_POINTS_PER_PIXEL*areaClientRect_.width, PREVIEW_MIN_POINTS);
+    return wxMax(1, int(curve->GetCount())/points);
+}
+
+bool wxPlotCtrl::RefineAreaBitmap()
+{
+    if (refinePos_ < 0) return false;
+
+    // wait for a pending paint, it draws a new preview and starts over,
+    //   when drawing asynchronously the paint is what started it
+    int waitNeed = (asyncDraw_ || areaPreview_) ? REDRAW_BLOCKER : (REDRAW_PLOT|REDRAW_BLOCKER);
+    if (((redrawNeed_ & waitNeed) != 0) || IsFramePending() || !area_->bitmap_.Ok())
+        return false;
+
+    wxRect clientRect(GetPlotAreaRect());
+    int count = GetCurveCount();
+    int activeIndex = GetActiveIndex();
+
+    // the curves are refined in the order they're drawn, active one last
+    auto curveAt = [&](int pos)
+    {
+        if ((activeIndex < 0) || (pos < activeIndex)) return pos;
+        return (pos == count - 1) ? activeIndex : pos + 1;
+    };
+
+    wxMemoryDC mdc;
+    if ((refinePos_ == 0) && (refineIndex_ == 0))
+    {
+        if (!refineBitmap_.Ok() ||
+            (refineBitmap_.GetWidth()  != clientRect.width) ||
+            (refineBitmap_.GetHeight() != clientRect.height))
+        {
+            refineBitmap_.Create(clientRect.width, clientRect.height);
+        }
+
+        mdc.SelectObject(refineBitmap_);
+        mdc.DrawBitmap(UpdateAreaLayers(), 0, 0, false);
+
+        if (refinePickBuffer_)
+            refinePickBuffer_->Reset(clientRect.GetSize(), viewRect_, zoom_);
+    }
+    else
+        mdc.SelectObject(refineBitmap_);
+
+    mdc.SetClippingRegion(clientRect);
+
+    wxStopWatch stopWatch;
+    while (refinePos_ < count)
+    {
+        int index = curveAt(refinePos_);
+        wxPlotData *curve = GetCurve(index);
+        int points = (curve && curve->Ok()) ? curve->GetCount() : 0;
+        int end = wxMin(refineIndex_ + REFINE_CHUNK_SIZE, points);
+
+        // each part starts at the last point of the one before to join them,
+        //   the symbols and density of the curve are kept for all its parts
+        if (end > refineIndex_)
+        {
+            if (refineIndex_ == 0)
+                dataCurveDrawer_->BeginParts();
+
+            dataCurveDrawer_->SetPickBuffer(refinePickBuffer_);
+            dataCurveDrawer_->SetDCRect(clientRect);
+            dataCurveDrawer_->SetPlotViewRect(viewRect_);
+            dataCurveDrawer_->DrawPart(&mdc, curve, index, wxMax(refineIndex_ - 1, 0), end);
+            if (end == points)
+                dataCurveDrawer_->EndParts(&mdc, curve, index);
+            dataCurveDrawer_->SetPickBuffer(NULL);
+        }
+
+        if (end < points)
+            refineIndex_ = end;
+        else
+        {
+            refinePos_++;
+            refineIndex_ = 0;
+        }
+
+        if (stopWatch.Time() >= REFINE_TIME_SLICE)
+            break;
+    }
+
+    if (refinePos_ < count)
+    {
+        mdc.DestroyClippingRegion();
+        mdc.SelectObject(wxNullBitmap);
+        return true;
+    }
+
+    DrawAreaForeground(&mdc, clientRect);
+    mdc.DestroyClippingRegion();
+    mdc.SelectObject(wxNullBitmap);
+
+    // show the full detail and keep the preview to draw the next one into
+    wxBitmap temp(area_->bitmap_);
+    area_->bitmap_ = refineBitmap_;
+    refineBitmap_ = temp;
+    std::swap(pickBuffer_, refinePickBuffer_);
+
+    // anything that changed meanwhile would have cancelled it, all is current
+    dirtyRegion_.Clear();
+    redrawNeed_ &= ~REDRAW_PLOT;
+    bitmapView_ = viewRect_;
+    bitmapZoom_ = zoom_;
+    areaPreview_ = false;
+
+    refinePos_ = -1;
+    area_->Refresh(false);
+    return false;
+}
+
+void wxPlotCtrl::StartAsyncFrame()
+{
+    if (asyncDraw_ && RequestRenderFrame())
+        return;
+
+    if (refinePos_ >= 0) return;
+
+    refinePos_ = 0;
+    refineIndex_ = 0;
+}
+
+bool wxPlotCtrl::RequestRenderFrame()
+{
+#if wxUSE_THREADS
+    // the thread only draws plain lines and symbols
+    if (GetDrawSpline() || GetDrawDensity())
+        return false;
+
+    if (renderThread_ && (renderRequested_ == renderGeneration_))
+        return true;
+
+    if (!renderThread_)
+    {
+        renderThread_ = new wxPlotRenderThread(this, ID_RENDER_THREAD);
+        if (renderThread_->Run() != wxTHREAD_NO_ERROR)
+        {
+            delete renderThread_;
+            renderThread_ = nullptr;
+            return false;
+        }
+    }
+
+    wxRect clientRect(GetPlotAreaRect());
+    wxPlotRenderFrame *frame = new wxPlotRenderFrame;
+    frame->generation_ = renderGeneration_;
+    frame->size_ = clientRect.GetSize();
+    frame->view_ = viewRect_;
+    frame->zoom_ = zoom_;
+    frame->drawLines_ = GetDrawLines();
+    frame->drawSymbols_ = GetDrawSymbols();
+
+    // the curves are drawn in the same order as DrawAreaWindow, active one last
+    int count = GetCurveCount();
+    int activeIndex = GetActiveIndex();
+    frame->curves_.reserve(count);
+    for (int pos = 0; pos < count; pos++)
+    {
+        int index = ((activeIndex < 0) || (pos < activeIndex)) ? pos :
+                    ((pos == count - 1) ? activeIndex : pos + 1);
+        wxPlotData *curve = GetCurve(index);
+        if (!curve || !curve->Ok())
+            continue;
+
+        wxPen pen(curve->GetPen((index == activeIndex) ? wxPlotData::PenColorType::ACTIVE
+                                                       : wxPlotData::PenColorType::NORMAL));
+        wxPen selectedPen(curve->GetPen(wxPlotData::PenColorType::SELECTED));
+
+        // dashes and the like are left to wxPlotDrawerDataCurve
+        if ((pen.GetStyle() != wxPENSTYLE_SOLID) || (selectedPen.GetStyle() != wxPENSTYLE_SOLID))
+        {
+            delete frame;
+            return false;
+        }
+
+        // the thread gets its own copy of the points, the curve may be changed
+        //   in place meanwhile, only the ones in view if it's ordered
+        int start, end;
+        GetCurveSpanInRect(curve, clientRect, start, end);
+
+        frame->curves_.push_back(wxPlotRenderFrame::Curve());
+        wxPlotRenderFrame::Curve &c = frame->curves_.back();
+        c.xs_.assign(curve->GetXData() + start, curve->GetXData() + end);
+        c.ys_.assign(curve->GetYData() + start, curve->GetYData() + end);
+        c.first_ = start;
+        c.selection_ = *GetDataCurveSelection(index);
+        c.colour_[0] = pen.GetColour().Red();
+        c.colour_[1] = pen.GetColour().Green();
+        c.colour_[2] = pen.GetColour().Blue();
+        c.selectedColour_[0] = selectedPen.GetColour().Red();
+        c.selectedColour_[1] = selectedPen.GetColour().Green();
+        c.selectedColour_[2] = selectedPen.GetColour().Blue();
+        c.width_ = wxMax(pen.GetWidth(), 1);
+        c.selectedWidth_ = wxMax(selectedPen.GetWidth(), 1);
+    }
+
+    renderRequested_ = renderGeneration_;
+    renderThread_->Request(frame);
+    return true;
+#else
+    return false;
+#endif // wxUSE_THREADS
+}
+
+#if wxUSE_THREADS
+void wxPlotCtrl::OnRenderThread(wxThreadEvent &event)
+{
+    if (!renderThread_ || (event.GetId() != ID_RENDER_THREAD))
+    {
+        event.Skip();
+        return;
+    }
+
+    std::vector<wxPlotRenderFrame*> frames;
+    renderThread_->TakeDone(frames);
+
+    // only the newest can be current, the others were dropped or are stale
+    wxPlotRenderFrame *frame = frames.empty() ? NULL : frames.back();
+    wxRect clientRect(GetPlotAreaRect());
+    if (frame && frame->complete_ && (frame->generation_ == renderGeneration_))
+    {
+        if (!asyncDraw_ || (frame->view_ != viewRect_) || (frame->zoom_ != zoom_) ||
+            (frame->size_ != clientRect.GetSize()) || IsFramePending() ||
+            ((redrawNeed_ & REDRAW_BLOCKER) != 0) || !area_->bitmap_.Ok())
+        {
+            // request it again at the next paint
+            renderRequested_ = 0;
+            area_->Refresh(false);
+        }
+        else
+        {
+            const int width = frame->size_.x, height = frame->size_.y;
+            wxImage image(width, height, false);
+            image.InitAlpha();
+            unsigned char *rgb = image.GetData();
+            unsigned char *alpha = image.GetAlpha();
+            const unsigned char *src = &frame->rgba_[0];
+            for (size_t p = 0, n = size_t(width)*height; p < n; p++, src += 4)
+            {
+                *rgb++ = src[0];
+                *rgb++ = src[1];
+                *rgb++ = src[2];
+                *alpha++ = src[3];
+            }
+
+            if (!refineBitmap_.Ok() ||
+                (refineBitmap_.GetWidth()  != width) ||
+                (refineBitmap_.GetHeight() != height))
+            {
+                refineBitmap_.Create(width, height);
+            }
+
+            wxMemoryDC mdc;
+            mdc.SelectObject(refineBitmap_);
+            mdc.DrawBitmap(UpdateAreaLayers(), 0, 0, false);
+            mdc.DrawBitmap(wxBitmap(image), 0, 0, true);
+            mdc.SetClippingRegion(clientRect);
+            DrawAreaForeground(&mdc, clientRect);
+            mdc.DestroyClippingRegion();
+            mdc.SelectObject(wxNullBitmap);
+
+            // show it like RefineAreaBitmap does, the thread has no pick buffer
+            wxBitmap temp(area_->bitmap_);
+            area_->bitmap_ = refineBitmap_;
+            refineBitmap_ = temp;
+            if (pickBuffer_)
+                pickBuffer_->Invalidate();
+
+            dirtyRegion_.Clear();
+            redrawNeed_ &= ~REDRAW_PLOT;
+            bitmapView_ = viewRect_;
+            bitmapZoom_ = zoom_;
+            areaPreview_ = false;
+
+            refinePos_ = -1;
+            area_->Refresh(false);
+        }
+    }
+
+    for (size_t i = 0; i < frames.size(); i++)
+        delete frames[i];
+}
+#endif // wxUSE_THREADS
+
+void wxPlotCtrl::PreviewAreaView()
+{
+    wxBitmap &bitmap = area_->bitmap_;
+    if (!zoomPreview_ || batchCount_ || !bitmap.Ok() ||
+        (bitmap.GetWidth()  != areaClientRect_.width) ||
+        (bitmap.GetHeight() != areaClientRect_.height) ||
+        (bitmapView_.m_width <= 0) || (bitmapView_.m_height <= 0) ||
+        (frameShift_ != wxPoint(0, 0)))
+    {
+        return;
+    }
+
+    // only worth it if the exact area can't be drawn within a frame
+    if (!asyncDraw_ && (lastAreaDrawTime_ < FRAME_INTERVAL))
+        return;
+
+    // where the corners of the bitmap are in the new view
+    double sx = zoom_.m_x/bitmapZoom_.m_x;
+    double sy = zoom_.m_y/bitmapZoom_.m_y;
+    double x = (bitmapView_.m_x - viewRect_.m_x)*zoom_.m_x;
+    double y = areaClientRect_.height*(1 - sy) - (bitmapView_.m_y - viewRect_.m_y)*zoom_.m_y;
+    double w = bitmap.GetWidth()*sx;
+    double h = bitmap.GetHeight()*sy;
+
+    // a scale this extreme shows nothing useful
+    const double limit = 32000;
+    if (!wxFinite(x) || !wxFinite(y) || !wxFinite(w) || !wxFinite(h) ||
+        (fabs(x) > limit) || (fabs(y) > limit) || (w < 1) || (h < 1) || (w > limit) || (h > limit))
+    {
+        return;
+    }
+
+    if (!area_->shiftBitmap_.Ok() ||
+        (area_->shiftBitmap_.GetWidth()  != areaClientRect_.width) ||
+        (area_->shiftBitmap_.GetHeight() != areaClientRect_.height))
+    {
+        area_->shiftBitmap_.Create(areaClientRect_.width, areaClientRect_.height);
+    }
+
+    wxMemoryDC srcDC;
+    srcDC.SelectObjectAsSource(bitmap);
+    wxMemoryDC mdc;
+    mdc.SelectObject(area_->shiftBitmap_);
+    mdc.SetBackground(*wxTheBrushList->FindOrCreateBrush(GetBackgroundColour(), wxBRUSHSTYLE_SOLID));
+    mdc.Clear();
+    mdc.StretchBlit(RINT(x), RINT(y), RINT(w), RINT(h),
+                    &srcDC, 0, 0, bitmap.GetWidth(), bitmap.GetHeight());
+    mdc.SelectObject(wxNullBitmap);
+    srcDC.SelectObject(wxNullBitmap);
 
-    if (need & REDRAW_WINDOW)
-        Refresh();
+    wxBitmap temp(bitmap);
+    bitmap = area_->shiftBitmap_;
+    area_->shiftBitmap_ = temp;
+
+    bitmapView_ = viewRect_;
+    bitmapZoom_ = zoom_;
+    areaPreview_ = true;
+    refinePos_ = -1;
+    area_->Refresh(false);
 }
 
-void wxPlotCtrl::DrawAreaWindow(wxDC *dc, const wxRect &rect)
+void wxPlotCtrl::DrawAreaBackground(wxDC *dc, const wxRect &rect)
 {
     wxCHECK_RET(dc, wxT("invalid dc"));
 
-    // GTK doesn't like invalid parameters
-    wxRect refreshRect = rect;
-    wxRect clientRect(GetPlotAreaRect());
-    refreshRect.Intersect(clientRect);
-
-    if ((refreshRect.width == 0) || (refreshRect.height == 0)) return;
-
-    dc->SetClippingRegion(refreshRect);
-
-    dc->SetBrush(wxBrush(GetBackgroundColour(), wxBRUSHSTYLE_SOLID));
-    dc->SetPen(wxPen(gridType_ == GridType::SmithChart ? GetBackgroundColour() : GetBorderColour(), areaBorderWidth_, wxPENSTYLE_SOLID));
-    dc->DrawRectangle(clientRect);
+    dc->SetBrush(*wxTheBrushList->FindOrCreateBrush(GetBackgroundColour(), wxBRUSHSTYLE_SOLID));
+    dc->SetPen(*wxThePenList->FindOrCreatePen(gridType_ == GridType::SmithChart ? GetBackgroundColour() : GetBorderColour(), areaBorderWidth_, wxPENSTYLE_SOLID));
+    dc->DrawRectangle(GetPlotAreaRect());
     if (gridType_ == GridType::SmithChart)
-        dc->SetPen(wxPen(GetBorderColour(), areaBorderWidth_, wxPENSTYLE_SOLID));
+        dc->SetPen(*wxThePenList->FindOrCreatePen(GetBorderColour(), areaBorderWidth_, wxPENSTYLE_SOLID));
 
     if (GetDrawGrid())
-        DrawGridLines(dc, refreshRect);
+        DrawGridLines(dc, rect);
     if (GetDrawTicks() && !GetDrawGrid())
-        DrawTickMarks(dc, refreshRect);
-    DrawMarkers(dc, refreshRect);
+        DrawTickMarks(dc, rect);
+}
 
-    dc->DestroyClippingRegion();
+bool wxPlotCtrl::AreaLayerKey::operator==(const AreaLayerKey &other) const
+{
+    if ((viewRect_ != other.viewRect_) || (size_ != other.size_) ||
+        (gridType_ != other.gridType_) ||
+        (backgroundColour_ != other.backgroundColour_) ||
+        (gridColour_ != other.gridColour_) ||
+        (borderColour_ != other.borderColour_) ||
+        (borderWidth_ != other.borderWidth_) ||
+        (drawGrid_ != other.drawGrid_) || (drawTicks_ != other.drawTicks_) ||
+        (bottomTicks_.GetCount() != other.bottomTicks_.GetCount()) ||
+        (leftTicks_.GetCount() != other.leftTicks_.GetCount()))
+        return false;
 
-    int i;
-    wxPlotData *curve;
-    wxPlotData *activeCurve = GetActiveCurve();
-    for (i = 0; i < GetCurveCount(); i++)
+    size_t i;
+    for (i = 0; i < bottomTicks_.GetCount(); i++)
+        if (bottomTicks_[i] != other.bottomTicks_[i]) return false;
+    for (i = 0; i < leftTicks_.GetCount(); i++)
+        if (leftTicks_[i] != other.leftTicks_[i]) return false;
+
+    return true;
+}
+
+wxPlotCtrl::AreaLayerKey wxPlotCtrl::GetAreaLayerKey() const
+{
+    AreaLayerKey key;
+    key.viewRect_ = viewRect_;
+    key.size_ = GetPlotAreaRect().GetSize();
+    key.gridType_ = gridType_;
+    key.backgroundColour_ = GetBackgroundColour();
+    key.gridColour_ = GetGridColour();
+    key.borderColour_ = GetBorderColour();
+    key.borderWidth_ = areaBorderWidth_;
+    key.drawGrid_ = drawGrid_;
+    key.drawTicks_ = drawTicks_;
+    key.bottomTicks_ = bottomAxisTicks_.positions_;
+    key.leftTicks_ = leftAxisTicks_.positions_;
+    return key;
+}
+
+const wxBitmap &wxPlotCtrl::UpdateAreaLayers()
+{
+    wxRect clientRect(GetPlotAreaRect());
+    AreaLayerKey key(GetAreaLayerKey());
+
+    if (!backgroundLayer_.Ok() || !(key == backgroundLayerKey_))
     {
-        curve = GetCurve(i);
+        if (!backgroundLayer_.Ok() || (backgroundLayer_.GetSize() != clientRect.GetSize()))
+            backgroundLayer_.Create(clientRect.width, clientRect.height);
 
-        if (curve != activeCurve)
-            DrawDataCurve(dc, curve, i, refreshRect);
+        wxMemoryDC mdc;
+        mdc.SelectObject(backgroundLayer_);
+        DrawAreaBackground(&mdc, clientRect);
+        mdc.SetPen(wxNullPen);
+        mdc.SetBrush(wxNullBrush);
+        mdc.SelectObject(wxNullBitmap);
+
+        backgroundLayerKey_ = key;
+        markersLayerValid_ = false;
     }
-    // active curve is drawn on top
-    if (activeCurve)
-        DrawDataCurve(dc, activeCurve, GetActiveIndex(), refreshRect);
 
-    DrawCurveCursor(dc);
-    DrawKey(dc);
+    if (plotMarkers_.IsEmpty())
+        return backgroundLayer_;
 
-    // refresh border
-    dc->SetBrush(*wxTRANSPARENT_BRUSH);
-    if (gridType_ != GridType::SmithChart)
-        dc->SetPen(wxPen(GetBorderColour(), areaBorderWidth_, wxPENSTYLE_SOLID));
-    else
-        dc->SetPen(wxPen(GetBackgroundColour(), areaBorderWidth_, wxPENSTYLE_SOLID));
-    dc->DrawRectangle(clientRect);
+    if (!markersLayerValid_ || (markersLayerVersion_ != markersVersion_))
+    {
+        markersLayer_ = backgroundLayer_.GetSubBitmap(clientRect);
 
-    dc->SetPen(wxNullPen);
-    dc->SetBrush(wxNullBrush);
+        wxMemoryDC mdc;
+        mdc.SelectObject(markersLayer_);
+        // markers without their own pen use the grid pen, as when drawn directly
+        mdc.SetPen(*wxThePenList->FindOrCreatePen(GetGridColour(), 1, wxPENSTYLE_SOLID));
+        mdc.SetClippingRegion(clientRect);
+        DrawMarkers(&mdc, clientRect);
+        mdc.DestroyClippingRegion();
+        mdc.SetPen(wxNullPen);
+        mdc.SetBrush(wxNullBrush);
+        mdc.SelectObject(wxNullBitmap);
+
+        markersLayerVersion_ = markersVersion_;
+        markersLayerValid_ = true;
+    }
+
+    return markersLayer_;
 }
 
 void wxPlotCtrl::DrawMouseMarker(wxDC *dc, MarkerType type, const wxRect &rect)
@@ -2845,10 +4428,8 @@ void wxPlotCtrl::DrawMouseMarker(wxDC *dc, MarkerType type, const wxRect &rect)
     if ((rect.width == 0) || (rect.height == 0))
         return;
 
-    wxRasterOperationMode logical_fn = dc->GetLogicalFunction();
-    dc->SetLogicalFunction(wxINVERT);
     dc->SetBrush(*wxTRANSPARENT_BRUSH);
-    dc->SetPen(*wxThePenList->FindOrCreatePen(*wxBLACK, 1, wxPENSTYLE_DOT));
+    dc->SetPen(*wxThePenList->FindOrCreatePen(GetOverlayColour(), 1, wxPENSTYLE_DOT));
 
     switch (type)
     {
@@ -2865,7 +4446,7 @@ void wxPlotCtrl::DrawMouseMarker(wxDC *dc, MarkerType type, const wxRect &rect)
         {
             if (rect.width != 0)
             {
-                int height = GetClientSize().y;
+                int height = areaClientRect_.height;
                 dc->DrawLine(rect.x, 1, rect.x, height-2);
                 dc->DrawLine(rect.GetRight()+1, 1, rect.GetRight()+1, height-2);
             }
@@ -2875,7 +4456,7 @@ void wxPlotCtrl::DrawMouseMarker(wxDC *dc, MarkerType type, const wxRect &rect)
         {
             if (rect.height != 0)
             {
-                int width = GetClientSize().x;
+                int width = areaClientRect_.width;
                 dc->DrawLine(1, rect.y, width-2, rect.y);
                 dc->DrawLine(1, rect.GetBottom()+1, width-2, rect.GetBottom()+1);
             }
@@ -2887,21 +4468,82 @@ void wxPlotCtrl::DrawMouseMarker(wxDC *dc, MarkerType type, const wxRect &rect)
 
     dc->SetBrush(wxNullBrush);
     dc->SetPen(wxNullPen);
-    dc->SetLogicalFunction(logical_fn);
 }
 
 void wxPlotCtrl::DrawCrosshairCursor(wxDC *dc, const wxPoint &pos)
 {
     wxCHECK_RET(dc, wxT("invalid window"));
 
-    dc->SetPen(*wxBLACK_PEN);
-    wxRasterOperationMode logical_fn = dc->GetLogicalFunction();
-    dc->SetLogicalFunction(wxINVERT);
+    dc->SetPen(*wxThePenList->FindOrCreatePen(GetOverlayColour(), 1, wxPENSTYLE_SOLID));
 
     dc->CrossHair(pos.x, pos.y);
 
     dc->SetPen(wxNullPen);
-    dc->SetLogicalFunction(logical_fn);
+}
+
+wxColour wxPlotCtrl::GetOverlayColour() const
+{
+    const wxColour &back = GetBackgroundColour();
+    int luma = (back.Red()*299 + back.Green()*587 + back.Blue()*114)/1000;
+    return (luma > 127) ? *wxBLACK : *wxWHITE;
+}
+
+void wxPlotCtrl::RefreshAreaOverlay(const wxRect &rect)
+{
+    if (!area_)
+        return;
+
+    wxRect refreshRect(rect);
+    refreshRect.Intersect(areaClientRect_);
+
+    if ((refreshRect.width > 0) && (refreshRect.height > 0))
+        area_->RefreshRect(refreshRect, false);
+}
+
+void wxPlotCtrl::RefreshCrosshairCursor(const wxPoint &pos)
+{
+    if (!areaClientRect_.Contains(pos))
+        return;
+
+    RefreshAreaOverlay(wxRect(0, pos.y-1, areaClientRect_.width, 3));
+    RefreshAreaOverlay(wxRect(pos.x-1, 0, 3, areaClientRect_.height));
+}
+
+void wxPlotCtrl::RefreshMouseMarker(MarkerType type, const wxRect &rect)
+{
+    if ((rect.width == 0) || (rect.height == 0))
+        return;
+
+    switch (type)
+    {
+        case MarkerType::RECT:
+        {
+            // the drag rect can have a negative size
+            wxRect r(rect);
+            if (r.width < 0)  { r.x += r.width;  r.width  = -r.width;  }
+            if (r.height < 0) { r.y += r.height; r.height = -r.height; }
+
+            RefreshAreaOverlay(wxRect(r.x-2, r.y-2, r.width+4, 5));
+            RefreshAreaOverlay(wxRect(r.x-2, r.GetBottom()-2, r.width+4, 5));
+            RefreshAreaOverlay(wxRect(r.x-2, r.y-2, 5, r.height+4));
+            RefreshAreaOverlay(wxRect(r.GetRight()-2, r.y-2, 5, r.height+4));
+            break;
+        }
+        case MarkerType::VERT:
+        {
+            RefreshAreaOverlay(wxRect(rect.x-2, 0, 5, areaClientRect_.height));
+            RefreshAreaOverlay(wxRect(rect.GetRight()-1, 0, 5, areaClientRect_.height));
+            break;
+        }
+        case MarkerType::HORIZ:
+        {
+            RefreshAreaOverlay(wxRect(0, rect.y-2, areaClientRect_.width, 5));
+            RefreshAreaOverlay(wxRect(0, rect.GetBottom()-1, areaClientRect_.width, 5));
+            break;
+        }
+        default:
+            break;
+    }
 }
 
 void wxPlotCtrl::DrawDataCurve(wxDC *dc, wxPlotData *curve, int curve_index, const wxRect &rect)
@@ -2913,6 +4555,16 @@ void wxPlotCtrl::DrawDataCurve(wxDC *dc, wxPlotData *curve, int curve_index, con
     dataCurveDrawer_->Draw(dc, curve, curve_index);
 }
 
+void wxPlotCtrl::DrawDataCurvePart(wxDC *dc, wxPlotData *curve, int curve_index, const wxRect &rect,
+                                   int startIndex, int endIndex, int stride)
+{
+    wxCHECK_RET(dc && dataCurveDrawer_ && curve && curve->Ok(), wxT("invalid curve"));
+
+    dataCurveDrawer_->SetDCRect(rect);
+    dataCurveDrawer_->SetPlotViewRect(viewRect_);
+    dataCurveDrawer_->Draw(dc, curve, curve_index, startIndex, endIndex, stride);
+}
+
 void wxPlotCtrl::RedrawCurve(int index, int minIndex, int maxIndex)
 {
     if (batchCount_) return;
@@ -2925,15 +4577,103 @@ void wxPlotCtrl::RedrawCurve(int index, int minIndex, int maxIndex)
     int count = plotData->GetCount();
     wxCHECK_RET((minIndex <= maxIndex) && (minIndex >= 0) && (maxIndex >= 0) && (minIndex < count) && (maxIndex < count), wxT("invalid data index"));
 
-    wxRect rect(areaClientRect_);
+    // pixel bounds of the changed points and the segments leading to them
+    const double *x_data = plotData->GetXData();
+    const double *y_data = plotData->GetYData();
+    int n, n_start = wxMax(minIndex - 1, 0), n_end = wxMin(maxIndex + 1, count - 1);
 
-    wxMemoryDC mdc;
-    mdc.SelectObject(area_->bitmap_);
-    DrawDataCurve(&mdc, plotData, index, rect);
-    DrawCurveCursor(&mdc);
-    wxClientDC dc(area_);
-    dc.Blit(rect.x, rect.y, rect.width, rect.height, &mdc, rect.x, rect.y);
-    mdc.SelectObject(wxNullBitmap);
+    int margin = cursorMarker_.GetSize().x + 4;
+    margin += wxMax(plotData->GetPen(wxPlotData::PenColorType::ACTIVE).GetWidth(),
+              wxMax(plotData->GetPen(wxPlotData::PenColorType::NORMAL).GetWidth(),
+                    plotData->GetPen(wxPlotData::PenColorType::SELECTED).GetWidth()));
+    double left = -margin, right = areaClientRect_.width + margin;
+    double top = -margin, bottom = areaClientRect_.height + margin;
+    double x0 = right, x1 = left, y0 = bottom, y1 = top;
+
+    for (n = n_start; n <= n_end; n++)
+    {
+        double x = zoom_.m_x*(x_data[n] - viewRect_.GetLeft());
+        double y = areaClientRect_.height - zoom_.m_y*(y_data[n] - viewRect_.GetTop());
+        if (!wxFinite(x) || !wxFinite(y)) continue;
+
+        x0 = wxMin(x0, wxMax(x, left)); x1 = wxMax(x1, wxMin(x, right));
+        y0 = wxMin(y0, wxMax(y, top));  y1 = wxMax(y1, wxMin(y, bottom));
+    }
+
+    if ((x0 > x1) || (y0 > y1)) return;
+
+    wxRect rect(int(floor(x0)) - margin, int(floor(y0)) - margin,
+                int(ceil(x1 - x0)) + 2*margin + 1, int(ceil(y1 - y0)) + 2*margin + 1);
+
+    // while only this curve is out of date, only the points that changed and
+    //   the segments to them are drawn of it, see DrawAreaWindow
+    wxRangeInt span(n_start, n_end);
+    bool spanOnly = dirtyRegion_.IsEmpty() || (redrawSpanCurve_ == index);
+    if (redrawSpanCurve_ == index)
+        span = span.Union(redrawSpan_);
+
+    // the background is restored from the cached layers and the other
+    //   curves are drawn clipped to rect
+    RedrawRect(rect);
+
+    if (spanOnly && !dirtyRegion_.IsEmpty())
+    {
+        redrawSpanCurve_ = index;
+        redrawSpan_ = span;
+    }
+}
+
+void wxPlotCtrl::GetCurveSpanInRect(wxPlotData *curve, const wxRect &rect, int &start, int &end) const
+{
+    start = 0;
+    end = curve->GetCount();
+    if (!curve->GetIsXOrdered() || (end < 2))
+        return;
+
+    // the points within the pen width and symbols of the rect, and the one
+    //   on either side of them for the lines in and out
+    int margin = wxMax(curve->GetPen(wxPlotData::PenColorType::ACTIVE).GetWidth(),
+                 wxMax(curve->GetPen(wxPlotData::PenColorType::NORMAL).GetWidth(),
+                       curve->GetPen(wxPlotData::PenColorType::SELECTED).GetWidth())) + 4;
+    double left  = GetPlotCoordFromClientX(rect.x - margin);
+    double right = GetPlotCoordFromClientX(rect.GetRight() + margin);
+    if (!wxFinite(left) || !wxFinite(right))
+        return;
+
+    const double *x_data = curve->GetXData();
+    int lo = int(std::lower_bound(x_data, x_data + end, left) - x_data);
+    int hi = int(std::upper_bound(x_data, x_data + end, right) - x_data);
+    start = wxMax(lo - 1, 0);
+    end = wxMin(hi + 1, end);
+}
+
+void wxPlotCtrl::GetClientCoordsFromPlotX(const double *plotx, int *clientx, int count) const
+{
+    // same arithmetic as GetClientCoordFromPlotX so the pixels match exactly,
+    //   no branches in the loop so the compiler can vectorize it
+    const double zoom = zoom_.m_x;
+    const double left = viewRect_.GetLeft();
+    for (int i = 0; i < count; i++)
+    {
+        double x = zoom*(plotx[i] - left) + 0.5;
+        x = x < INT_MAX ? x : INT_MAX;
+        x = x > INT_MIN ? x : INT_MIN;
+        clientx[i] = int(x);
+    }
+}
+
+void wxPlotCtrl::GetClientCoordsFromPlotY(const double *ploty, int *clienty, int count) const
+{
+    const double zoom = zoom_.m_y;
+    const double top = viewRect_.GetTop();
+    const double height = areaClientRect_.height;
+    for (int i = 0; i < count; i++)
+    {
+        double y = height - zoom*(ploty[i] - top) + 0.5;
+        y = y < INT_MAX ? y : INT_MAX;
+        y = y > INT_MIN ? y : INT_MIN;
+        clienty[i] = int(y);
+    }
 }
 
 void wxPlotCtrl::DrawKey(wxDC *dc)
@@ -3133,11 +4873,11 @@ void wxPlotCtrl::DrawSmithChartGrid(wxDC *dc, const wxRect &rect)
     const double OrtVals6[len6] = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
 
     // box
-    dc->SetPen(wxPen(*wxBLACK, 1, wxPENSTYLE_SOLID));
-    dc->SetBrush(wxBrush(GetBackgroundColour(), wxBRUSHSTYLE_TRANSPARENT));
+    dc->SetPen(*wxThePenList->FindOrCreatePen(*wxBLACK, 1, wxPENSTYLE_SOLID));
+    dc->SetBrush(*wxTheBrushList->FindOrCreateBrush(GetBackgroundColour(), wxBRUSHSTYLE_TRANSPARENT));
     dc->DrawArc(gopen, gopen, origin);
 
-    dc->SetPen(wxPen(GetGridColour(), 2, wxPENSTYLE_SOLID));
+    dc->SetPen(*wxThePenList->FindOrCreatePen(GetGridColour(), 2, wxPENSTYLE_SOLID));
 
     dc->DrawLine(gshort, gopen);//RealNumberLine
     drawConstRealCircles(Vals1, len1);
@@ -3145,7 +4885,7 @@ void wxPlotCtrl::DrawSmithChartGrid(wxDC *dc, const wxRect &rect)
     drawConstImaginaryAcrs(Vals1, len1);
     drawConstImaginaryAcrSections(Vals2, nullptr, OrtVals2, len2);
 
-    dc->SetPen(wxPen(GetGridColour(), 1, wxPENSTYLE_SOLID));
+    dc->SetPen(*wxThePenList->FindOrCreatePen(GetGridColour(), 1, wxPENSTYLE_SOLID));
 
     drawConstRealAcrs(Vals3, OrtVals3, len3);
     drawConstRealAcrSections(Vals4, OrtVals4_1, OrtVals4_2, len4);
@@ -3168,7 +4908,7 @@ void wxPlotCtrl::DrawTickMarks(wxDC *dc, const wxRect &rect)
 void wxPlotCtrl::DrawTickMarksOrGridLines(wxDC *dc, const wxRect &rect, bool ticksOnly)
 {
     wxRect clientRect(GetPlotAreaRect());
-    dc->SetPen(wxPen(GetGridColour(), 1, wxPENSTYLE_SOLID));
+    dc->SetPen(*wxThePenList->FindOrCreatePen(GetGridColour(), 1, wxPENSTYLE_SOLID));
 
     int xtickLength = ticksOnly ? 8 : clientRect.height;
     int ytickLength = ticksOnly ? 8 : clientRect.width;
@@ -3240,6 +4980,8 @@ void wxPlotCtrl::DrawWholePlot(wxDC *dc, const wxRect &boundingRect, double dpi)
     wxCHECK_RET(dc, wxT("invalid dc"));
     wxCHECK_RET(dpi > 0, wxT("Invalid dpi for plot drawing"));
 
+    FlushFrame(); // the ticks must be up to date
+
     //set font scale so 1pt = 1pixel at 72dpi
     double fontScale = (double)dpi / 72.0;
     //one pixel wide line equals (penPrintWidth_) millimeters wide
@@ -3310,7 +5052,9 @@ void wxPlotCtrl::DrawWholePlot(wxDC *dc, const wxRect &boundingRect, double dpi)
 
     dc->SetDeviceOrigin(long(boundingRect.x+areaRect_.GetLeft()),
                         long(boundingRect.y+areaRect_.GetTop()));
+    useAreaLayers_ = false; // draw at the printer resolution, not from the cache
     DrawAreaWindow(dc, areaClientRect_);
+    useAreaLayers_ = true;
 
     dc->SetDeviceOrigin(boundingRect.x, boundingRect.y);
     DrawPlotCtrl(dc);
@@ -3539,6 +5283,76 @@ void wxPlotCtrl::CalcYAxisTickPositions()
 // Event processing
 // ----------------------------------------------------------------------------
 
+int wxPlotCtrl::GetMouseMotionInterval() const
+{
+    return motionInterval_;
+}
+
+void wxPlotCtrl::SetMouseMotionInterval(int ms)
+{
+    motionInterval_ = wxMax(ms, 0);
+    if ((motionInterval_ == 0) && motionTimer_ && motionTimer_->IsRunning())
+        SendMouseMotionEvent();
+}
+
+void wxPlotCtrl::SetSkipUnhandledMouseMotion(bool skip)
+{
+    skipUnhandledMotion_ = skip;
+    motionUnhandled_ = false;
+}
+
+void wxPlotCtrl::QueueMouseMotionEvent()
+{
+    wxLongLong now = wxGetLocalTimeMillis();
+    long elapsed = (now - lastMotionTime_).ToLong();
+
+    // nobody wanted the last one, don't bother until it's time to ask again
+    if (skipUnhandledMotion_ && motionUnhandled_ &&
+        (elapsed >= 0) && (elapsed < MOTION_PROBE_INTERVAL))
+        return;
+
+    // too soon, the timer sends whatever the latest position is then
+    if ((motionInterval_ > 0) && (elapsed >= 0) && (elapsed < motionInterval_))
+    {
+        if (!motionTimer_)
+            motionTimer_ = new wxTimer(this, ID_MOTION_TIMER);
+
+        if (!motionTimer_->IsRunning())
+            motionTimer_->Start(motionInterval_ - int(elapsed), true); // one shot timer
+
+        return;
+    }
+
+    SendMouseMotionEvent();
+}
+
+void wxPlotCtrl::SendMouseMotionEvent()
+{
+    if (motionTimer_ && motionTimer_->IsRunning())
+        motionTimer_->Stop();
+
+    const wxPoint &mousePt = area_->lastMousePosition_;
+    lastMotionTime_ = wxGetLocalTimeMillis();
+
+    wxPlotCtrlEvent evt_motion(wxEVT_PLOTCTRL_MOUSE_MOTION, GetId(), this);
+    evt_motion.SetPosition(GetPlotCoordFromClientX(mousePt.x),
+                           GetPlotCoordFromClientY(mousePt.y));
+
+    // the point under the mouse costs nothing to find in the pick buffer
+    int pickCurve, pickIndex;
+    if (FindPickedPoint(mousePt, 2, pickCurve, pickIndex))
+    {
+        evt_motion.SetCurve(GetCurve(pickCurve), pickCurve);
+        evt_motion.SetCurveDataIndex(pickIndex);
+    }
+
+    // a handler that Skip()s it counts as unhandled, it only gets the probes
+    bool processed = true;
+    DoSendEvent(evt_motion, &processed);
+    if (skipUnhandledMotion_)
+        motionUnhandled_ = !processed;
+}
+
 void wxPlotCtrl::ProcessAreaMouseEvent(wxMouseEvent &event)
 {
     wxPoint &mousePt   = area_->lastMousePosition_;
@@ -3559,31 +5373,24 @@ void wxPlotCtrl::ProcessAreaMouseEvent(wxMouseEvent &event)
     double plotX = GetPlotCoordFromClientX(mousePt.x),
            plotY = GetPlotCoordFromClientY(mousePt.y);
 
-    wxClientDC dc(area_);
-
     // Mouse motion
     if (lastMousePt != area_->lastMousePosition_)
     {
-        wxPlotCtrlEvent evt_motion(wxEVT_PLOTCTRL_MOUSE_MOTION, GetId(), this);
-        evt_motion.SetPosition(plotX, plotY);
-        DoSendEvent(evt_motion);
+        QueueMouseMotionEvent();
 
-        // Draw the crosshair cursor
+        // Move the crosshair cursor, it's drawn in Area::OnPaint
         if (GetCrossHairCursor())
         {
-            if (!event.Entering() || area_->HasCapture())
-                DrawCrosshairCursor(&dc, lastMousePt);
-            if (!event.Leaving() || area_->HasCapture())
-                DrawCrosshairCursor(&dc, mousePt);
+            RefreshCrosshairCursor(lastMousePt);
+            RefreshCrosshairCursor(mousePt);
         }
     }
 
     // Wheel scrolling up and down
     if (event.GetWheelRotation() != 0)
     {
-        double dir = event.GetWheelRotation() > 0 ? 0.25 : -0.25;
-        SetOrigin(viewRect_.GetLeft(),
-                   viewRect_.GetTop() + dir*viewRect_.m_height, true);
+        int dy = areaClientRect_.height/4;
+        ShiftOrigin(0, event.GetWheelRotation() > 0 ? dy : -dy, true);
     }
 
     int active_index = GetActiveIndex();
@@ -3611,8 +5418,32 @@ void wxPlotCtrl::ProcessAreaMouseEvent(wxMouseEvent &event)
 
         wxPoint2DDouble dpt(2.0/zoom_.m_x, 2.0/zoom_.m_y);
         wxPoint2DDouble curvePt;
+        bool found = false;
+
+        // the pick buffer knows what's drawn where, if it's up to date
+        if (IsPickBufferValid())
+        {
+            found = FindPickedPoint(mousePt, 2, curveIndex, data_index, &curvePt);
+        }
+        else
+            found = FindCurve(wxPoint2DDouble(plotX, plotY), dpt, curveIndex, data_index, &curvePt);
 
-        if (FindCurve(wxPoint2DDouble(plotX, plotY), dpt, curveIndex, data_index, &curvePt))
+        // else a line between points, clicked at the point on the line
+        //   that's drawn and given the index of the nearer end
+        int index0, index1;
+        if (!found && !IsPickBufferValid() && GetDrawLines() &&
+            FindCurveSegment(wxPoint2DDouble(plotX, plotY), dpt, curveIndex, index0, index1, &curvePt))
+        {
+            wxPlotData *plotData = GetCurve(curveIndex);
+            double x0 = plotData->GetXValue(index0), x1 = plotData->GetXValue(index1);
+            double y0 = plotData->GetYValue(index0), y1 = plotData->GetYValue(index1);
+            double du0 = (curvePt.m_x - x0)/dpt.m_x, dv0 = (curvePt.m_y - y0)/dpt.m_y;
+            double du1 = (curvePt.m_x - x1)/dpt.m_x, dv1 = (curvePt.m_y - y1)/dpt.m_y;
+            data_index = (du0*du0 + dv0*dv0 <= du1*du1 + dv1*dv1) ? index0 : index1;
+            found = true;
+        }
+
+        if (found)
         {
             wxPlotData *plotData = GetCurve(curveIndex);
 
@@ -3653,6 +5484,9 @@ void wxPlotCtrl::ProcessAreaMouseEvent(wxMouseEvent &event)
         if (mouseDragRectangle == wxRect(0, 0, 0, 0))
             return;
 
+        // erase the marker, whatever happens next
+        RefreshMouseMarker(areaMouseMarker_, mouseDragRectangle);
+
         wxRect rightedRect = mouseDragRectangle;
 
         // rightedRect always goes from upper-left to lower-right
@@ -3680,8 +5514,6 @@ void wxPlotCtrl::ProcessAreaMouseEvent(wxMouseEvent &event)
             else if ((areaMouseMarker_ == MarkerType::HORIZ) &&
                      (rightedRect.height > 10))
                 SetZoom(wxRect(0, rightedRect.y, areaClientRect_.width, rightedRect.height), true);
-            else
-                DrawMouseMarker(&dc, areaMouseMarker_, mouseDragRectangle);
         }
         // Select a range of points
         else if ((areaMouseFunc_ == MouseFunction::SELECT) && (active_index >= 0))
@@ -3717,11 +5549,6 @@ void wxPlotCtrl::ProcessAreaMouseEvent(wxMouseEvent &event)
             mouseDragRectangle = wxRect(0,0,0,0);
             EndBatch();
         }
-        // Nothing to do - erase the rect
-        else
-        {
-            DrawMouseMarker(&dc, areaMouseMarker_, mouseDragRectangle);
-        }
 
         mouseDragRectangle = wxRect(0,0,0,0);
         return;
@@ -3744,23 +5571,20 @@ void wxPlotCtrl::ProcessAreaMouseEvent(wxMouseEvent &event)
 
             mouseDragRectangle = wxRect(0,0,0,0); // no marker
 
-            double dx = mousePt.x - lastMousePt.x;
-            double dy = mousePt.y - lastMousePt.y;
-            SetOrigin(viewRect_.GetLeft() - dx/zoom_.m_x,
-                      viewRect_.GetTop()  + dy/zoom_.m_y, true);
+            ShiftOrigin(mousePt.x - lastMousePt.x, mousePt.y - lastMousePt.y, true);
             return;
         }
         else
         {
             if (mouseDragRectangle != wxRect(0,0,0,0))
-                DrawMouseMarker(&dc, areaMouseMarker_, mouseDragRectangle);
+                RefreshMouseMarker(areaMouseMarker_, mouseDragRectangle);
             else
                 mouseDragRectangle = wxRect(mousePt, wxSize(1, 1));
 
             mouseDragRectangle.width  = mousePt.x - mouseDragRectangle.x;
             mouseDragRectangle.height = mousePt.y - mouseDragRectangle.y;
 
-            DrawMouseMarker(&dc, areaMouseMarker_, mouseDragRectangle);
+            RefreshMouseMarker(areaMouseMarker_, mouseDragRectangle);
         }
 
         return;
@@ -3921,12 +5745,12 @@ void wxPlotCtrl::OnChar(wxKeyEvent &event)
     switch (event.GetKeyCode())
     {
         // cursor keys moves the plot origin around
-        case WXK_LEFT    : SetOrigin(viewRect_.GetLeft() - viewRect_.m_width/10.0, viewRect_.GetTop()); return;
-        case WXK_RIGHT   : SetOrigin(viewRect_.GetLeft() + viewRect_.m_width/10.0, viewRect_.GetTop()); return;
-        case WXK_UP      : SetOrigin(viewRect_.GetLeft(), viewRect_.GetTop() + viewRect_.m_height/10.0); return;
-        case WXK_DOWN    : SetOrigin(viewRect_.GetLeft(), viewRect_.GetTop() - viewRect_.m_height/10.0); return;
-        case WXK_PAGEUP  : SetOrigin(viewRect_.GetLeft(), viewRect_.GetTop() + viewRect_.m_height/2.0); return;
-        case WXK_PAGEDOWN: SetOrigin(viewRect_.GetLeft(), viewRect_.GetTop() - viewRect_.m_height/2.0); return;
+        case WXK_LEFT    : ShiftOrigin( areaClientRect_.width/10, 0); return;
+        case WXK_RIGHT   : ShiftOrigin(-areaClientRect_.width/10, 0); return;
+        case WXK_UP      : ShiftOrigin(0,  areaClientRect_.height/10); return;
+        case WXK_DOWN    : ShiftOrigin(0, -areaClientRect_.height/10); return;
+        case WXK_PAGEUP  : ShiftOrigin(0,  areaClientRect_.height/2); return;
+        case WXK_PAGEDOWN: ShiftOrigin(0, -areaClientRect_.height/2); return;
 
         // Center the plot on the cursor point, or 0,0
         case WXK_HOME :
@@ -4108,8 +5932,7 @@ void wxPlotCtrl::OnScroll(wxScrollEvent &event)
         double origin_x = curveBoundingRect_.GetLeft() + curveBoundingRect_.m_width*(position/range);
         if (!IsFinite(origin_x, wxT("plot's x-origin is NaN")))
             return;
-        viewRect_.m_x = origin_x;
-        Redraw(REDRAW_PLOT | REDRAW_BOTTOM_AXIS);
+        ShiftOrigin(RINT((viewRect_.m_x - origin_x)*zoom_.m_x), 0);
     }
     else if (event.GetId() == ID_Y_SCROLLBAR)
     {
@@ -4121,8 +5944,7 @@ void wxPlotCtrl::OnScroll(wxScrollEvent &event)
         double origin_y = curveBoundingRect_.GetTop() + curveBoundingRect_.m_height*((range-position-thumbsize)/range);
         if (!IsFinite(origin_y, wxT("plot's y-origin is NaN")))
             return;
-        viewRect_.m_y = origin_y;
-        Redraw(REDRAW_PLOT | REDRAW_LEFT_AXIS);
+        ShiftOrigin(0, RINT((origin_y - viewRect_.m_y)*zoom_.m_y));
     }
 }
 
@@ -4153,38 +5975,19 @@ bool wxPlotCtrl::FindCurve(const wxPoint2DDouble &pt, const wxPoint2DDouble &dpt
     if (!IsFinite(dpt.m_x, wxT("point is not finite"))) return false;
     if (!IsFinite(dpt.m_y, wxT("point is not finite"))) return false;
 
-    int curve_count = GetCurveCount();
-    if (curve_count < 1) return false;
+    if (GetCurveCount() < 1) return false;
 
-    for (int n=-1; n<curve_count; n++)
-    {
-        // find the point in the selected curve first
-        if (n == -1)
-        {
-            if (activeIndex_ >= 0)
-                n = activeIndex_;
-            else
-                n = 0;
-        }
-        else if (n == activeIndex_)
-            continue;
+    std::vector<int> curves;
+    GetCurvesNear(pt, dpt, curves);
 
+    for (size_t c = 0; c < curves.size(); c++)
+    {
+        int n = curves[c];
         wxPlotData *plotData = GetCurve(n);
 
         // find the index of the closest point in a wxPlotData curve
         if (plotData)
         {
-            // check if curve has BoundingRect
-            wxRect2DDouble rect = plotData->GetBoundingRect();
-            if (((rect.m_width > 0) &&
-                 ((pt.m_x+dpt.m_x < rect.GetLeft()) || (pt.m_x-dpt.m_x > rect.GetRight()))) ||
-                 ((rect.m_height > 0) &&
-                 ((pt.m_y+dpt.m_y < rect.GetTop()) || (pt.m_y-dpt.m_y > rect.GetBottom()))))
-            {
-                if ((n == activeIndex_) && (n > 0)) n = -1; // start back at 0
-                continue;
-            }
-
             int index = plotData->GetIndexFromXY(pt.m_x, pt.m_y, dpt.m_x);
 
             double x = plotData->GetXValue(index);
@@ -4198,14 +6001,145 @@ bool wxPlotCtrl::FindCurve(const wxPoint2DDouble &pt, const wxPoint2DDouble &dpt
                 return true;
             }
         }
-        // continue searching through curves
-        // if on the current then start back at the beginning if not already at 0
-        if ((n == activeIndex_) && (n > 0)) n = -1;
     }
     return false;
 }
 
-bool wxPlotCtrl::DoSendEvent(wxPlotCtrlEvent &event) const
+bool wxPlotCtrl::IsPickBufferValid() const
+{
+    return pickBuffer_ && (pickBuffer_->size_ == areaClientRect_.GetSize()) &&
+           (pickBuffer_->view_ == viewRect_) && (pickBuffer_->zoom_ == zoom_);
+}
+
+bool wxPlotCtrl::FindPickedPoint(const wxPoint &clientPt, int radius,
+                                 int &curveIndex, int &data_index,
+                                 wxPoint2DDouble *curvePt) const
+{
+    curveIndex = data_index = -1;
+
+    int curve, index, other;
+    if (!IsPickBufferValid() || !pickBuffer_->Find(clientPt, radius, curve, index, &other))
+        return false;
+
+    // a curve changed or deleted since the buffer was drawn doesn't count
+    wxPlotData *plotData = CurveIndexOk(curve) ? GetCurve(curve) : NULL;
+    if (!plotData || (curve >= (int)pickBuffer_->dataVersions_.size()) ||
+        (pickBuffer_->dataVersions_[curve] != plotData->GetDataVersion()) ||
+        (index >= (int)plotData->GetCount()) || (other >= (int)plotData->GetCount()))
+        return false;
+
+    curveIndex = curve;
+    data_index = index;
+
+    if (curvePt)
+    {
+        wxPoint2DDouble p0(plotData->GetPoint(index));
+        *curvePt = p0;
+
+        // a line, the point on it nearest the click in pixels
+        if ((other >= 0) && (other != index))
+        {
+            wxPoint2DDouble p1(plotData->GetPoint(other));
+            double du = zoom_.m_x*(p1.m_x - p0.m_x), dv = zoom_.m_y*(p1.m_y - p0.m_y);
+            double u = clientPt.x - zoom_.m_x*(p0.m_x - viewRect_.GetLeft());
+            double v = (areaClientRect_.height - clientPt.y) - zoom_.m_y*(p0.m_y - viewRect_.GetTop());
+            double len2 = du*du + dv*dv;
+            if (len2 > 0)
+            {
+                double t = wxMax(0.0, wxMin(1.0, (u*du + v*dv)/len2));
+                *curvePt = wxPoint2DDouble(p0.m_x + t*(p1.m_x - p0.m_x), p0.m_y + t*(p1.m_y - p0.m_y));
+            }
+        }
+    }
+
+    return true;
+}
+
+void wxPlotCtrl::GetValuesAtX(double x, std::vector<double> &values) const
+{
+    int count = GetCurveCount();
+    values.resize(count);
+    // the indexes are only where the search starts, stale ones just cost more
+    valueIndexes_.resize(count, -1);
+
+    // many curves are read on threads, each only writes its own values
+    wxPlotParallelFor(count, VALUES_PARALLEL_MIN, [&](size_t start, size_t end)
+    {
+        for (size_t n = start; n < end; n++)
+        {
+            const wxPlotData &plotData = curves_[n];
+            if (plotData.Ok() && (plotData.GetCount() > 0))
+                values[n] = plotData.GetY(x, valueIndexes_[n]);
+            else
+                values[n] = wxDouble_limits.quiet_NaN();
+        }
+    });
+}
+
+bool wxPlotCtrl::FindCurveSegment(const wxPoint2DDouble &pt, const wxPoint2DDouble &dpt,
+                                  int &curveIndex, int &index0, int &index1,
+                                  wxPoint2DDouble *curvePt) const
+{
+    curveIndex = index0 = index1 = -1;
+
+    if (!IsFinite(pt.m_x,  wxT("point is not finite"))) return false;
+    if (!IsFinite(pt.m_y,  wxT("point is not finite"))) return false;
+    if (!IsFinite(dpt.m_x, wxT("point is not finite"))) return false;
+    if (!IsFinite(dpt.m_y, wxT("point is not finite"))) return false;
+
+    if ((GetCurveCount() < 1) || (dpt.m_x <= 0) || (dpt.m_y <= 0)) return false;
+
+    std::vector<int> curves;
+    GetCurvesNear(pt, dpt, curves);
+
+    for (size_t c = 0; c < curves.size(); c++)
+    {
+        wxPlotData *plotData = GetCurve(curves[c]);
+        double t;
+
+        if (plotData && plotData->GetSegmentFromXY(pt.m_x, pt.m_y, dpt.m_x, dpt.m_y, index0, index1, &t))
+        {
+            curveIndex = curves[c];
+            if (curvePt)
+            {
+                wxPoint2DDouble p0(plotData->GetPoint(index0)), p1(plotData->GetPoint(index1));
+                *curvePt = wxPoint2DDouble(p0.m_x + t*(p1.m_x - p0.m_x), p0.m_y + t*(p1.m_y - p0.m_y));
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void wxPlotCtrl::UpdateCurveTree()
+{
+    int i, count = curves_.GetCount();
+
+    // new curves are added, ones recalculated since are moved in the tree
+    for (i = 0; i < count; i++)
+    {
+        const wxPlotData &curve = curves_[i];
+        if (i >= curveTree_.GetCount())
+            curveTree_.Add(curve.GetBoundingRect(), curve.GetDataVersion());
+        else if (curveTree_.GetVersion(i) != curve.GetDataVersion())
+            curveTree_.Update(i, curve.GetBoundingRect(), curve.GetDataVersion());
+    }
+}
+
+void wxPlotCtrl::GetCurvesNear(const wxPoint2DDouble &pt, const wxPoint2DDouble &dpt,
+                               std::vector<int> &curves) const
+{
+    // only the curves whose bounding rects are near the point
+    curveTree_.Query(wxRect2DDouble(pt.m_x - dpt.m_x, pt.m_y - dpt.m_y, 2*dpt.m_x, 2*dpt.m_y), curves);
+
+    // the active curve first, then in order
+    std::sort(curves.begin(), curves.end());
+    std::vector<int>::iterator active = std::find(curves.begin(), curves.end(), activeIndex_);
+    if (active != curves.end())
+        std::rotate(curves.begin(), active, active + 1);
+}
+
+bool wxPlotCtrl::DoSendEvent(wxPlotCtrlEvent &event, bool *processed) const
 {
 /*
     if (event.GetEventType() != wxEVT_PLOTCTRL_MOUSE_MOTION)
@@ -4216,7 +6150,11 @@ bool wxPlotCtrl::DoSendEvent(wxPlotCtrlEvent &event) const
             event.GetX(), event.GetY(), event.GetMouseFunction());
     }
 */
-    return !GetEventHandler()->ProcessEvent(event) || event.IsAllowed();
+    bool done = GetEventHandler()->ProcessEvent(event);
+    if (processed)
+        *processed = done;
+
+    return !done || event.IsAllowed();
 }
 
 void wxPlotCtrl::StartMouseTimer(wxWindowID win_id)
@@ -4251,7 +6189,17 @@ void wxPlotCtrl::OnTimer(wxTimerEvent &event)
 {
     wxPoint mousePt;
 
-    if (event.GetId() == ID_AREA_TIMER)
+    if (event.GetId() == ID_FRAME_TIMER)
+    {
+        FlushFrame();
+        return;
+    }
+    else if (event.GetId() == ID_MOTION_TIMER)
+    {
+        SendMouseMotionEvent();
+        return;
+    }
+    else if (event.GetId() == ID_AREA_TIMER)
         mousePt = area_->lastMousePosition_;
     else if (event.GetId() == ID_XAXIS_TIMER)
         mousePt = bottomAxis_->lastMousePosition_;
@@ -4263,13 +6211,10 @@ void wxPlotCtrl::OnTimer(wxTimerEvent &event)
         return;
     }
 
-    double dx = (mousePt.x<0) ? -20 : (mousePt.x>GetPlotAreaRect().width) ?  20 : 0;
-    double dy = (mousePt.y<0) ?  20 : (mousePt.y>GetPlotAreaRect().height) ? -20 : 0;
-    dx /= zoom_.m_x;
-    dy /= zoom_.m_y;
+    int dx = (mousePt.x<0) ?  20 : (mousePt.x>GetPlotAreaRect().width) ? -20 : 0;
+    int dy = (mousePt.y<0) ?  20 : (mousePt.y>GetPlotAreaRect().height) ? -20 : 0;
 
-    if (((dx == 0) && (dy == 0)) ||
-        !SetOrigin(GetViewRect().GetLeft() + dx, GetViewRect().GetTop() + dy, true))
+    if (((dx == 0) && (dy == 0)) || !ShiftOrigin(dx, dy, true))
     {
         StopMouseTimer();
     }
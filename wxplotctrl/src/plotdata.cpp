@@ -10,6 +10,9 @@
 
 #include <math.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "wx/bitmap.h"
 #include "wx/textdlg.h"
 #include "wx/msgdlg.h"
@@ -18,6 +21,7 @@
 #include "wx/wfstream.h"
 #include "wx/textfile.h"
 #include "wx/math.h"
+#include "wx/thread.h"
 #include "wx/arrimpl.cpp"
 
 #include "wx/plotctrl/plotdata.h"
@@ -30,6 +34,8 @@ WX_DEFINE_OBJARRAY(wxArrayPen)
     wxCHECK_RET((int(val)>=int(min_val))&&(int(val)<=int(max_val)), msg)
 
 #define wxPLOTDATA_MAX_DATA_COLUMNS 64
+#define INTERPOLATE_BLOCK_SIZE 1024 // xs searched at once by GetY(xs, ys, n)
+#define INTERPOLATE_PARALLEL_MIN 262144 // xs per thread for GetY(xs, ys, n)
 
 #define CHECK_INDEX_COUNT_MSG(index, count, max_count, ret) \
     wxCHECK_MSG((int(index) >= 0) && (int(index)+int(count) <= int(max_count)), ret, wxT("invalid index or count"))
@@ -76,6 +82,11 @@ public:
     double *xs_;
     double *ys_;
     bool    static_;
+    bool    xOrdered_; // see wxPlotData::GetIsXOrdered
+
+    unsigned long dataVersion_; // see wxPlotData::GetDataVersion
+    unsigned long penVersion_;  // see wxPlotData::GetPenVersion
+    static unsigned long lastDataVersion_;
 
     wxBitmap normalSymbol_,
              activeSymbol_,
@@ -85,6 +96,7 @@ public:
 #define M_PLOTCURVEDATA ((wxPlotRefData*)m_refData)
 
 wxArrayPen wxPlotRefData::defaultPens_;
+unsigned long wxPlotRefData::lastDataVersion_ = 0;
 
 void InitPlotCurveDefaultPens()
 {
@@ -102,7 +114,10 @@ wxPlotRefData::wxPlotRefData():
     count_(0),
     xs_(nullptr),
     ys_(nullptr),
-    static_(false)
+    static_(false),
+    xOrdered_(false),
+    dataVersion_(++lastDataVersion_),
+    penVersion_(++lastDataVersion_)
 {
     InitPlotCurveDefaultPens();
     pens_ = defaultPens_;
@@ -112,7 +127,10 @@ wxPlotRefData::wxPlotRefData():
     selectedSymbol_ = wxPlotSymbolSelected;
 }
 
-wxPlotRefData::wxPlotRefData(const wxPlotRefData& data)
+wxPlotRefData::wxPlotRefData(const wxPlotRefData& data):
+    xs_(nullptr),
+    ys_(nullptr),
+    static_(false)
 {
     CopyData(data);
     CopyExtra(data);
@@ -142,6 +160,8 @@ void wxPlotRefData::CopyData(const wxPlotRefData &source)
 
     count_  = source.count_;
     static_ = false; // we're creating our own copy
+    xOrdered_ = source.xOrdered_;
+    dataVersion_ = ++lastDataVersion_;
 
     if (count_ && source.xs_)
     {
@@ -163,6 +183,7 @@ void wxPlotRefData::CopyExtra(const wxPlotRefData &source)
 
     boundingRect_ = source.boundingRect_;
     pens_         = source.pens_;
+    penVersion_   = ++lastDataVersion_;
 }
 
 #define M_PLOTDATA ((wxPlotRefData*)m_refData)
@@ -172,6 +193,73 @@ wxBitmap wxPlotSymbolNormal;
 wxBitmap wxPlotSymbolActive;
 wxBitmap wxPlotSymbolSelected;
 
+//----------------------------------------------------------------------------
+// wxPlotParallelFor
+//----------------------------------------------------------------------------
+#if wxUSE_THREADS
+// Runs a part of wxPlotParallelFor
+class wxPlotParallelThread: public wxThread
+{
+public:
+    wxPlotParallelThread(const std::function<void (size_t, size_t)> &func, size_t start, size_t end)
+        : wxThread(wxTHREAD_JOINABLE), func_(func), start_(start), end_(end) {}
+
+protected:
+    virtual ExitCode Entry()
+    {
+        func_(start_, end_);
+        return (ExitCode)0;
+    }
+
+    const std::function<void (size_t, size_t)> &func_;
+    size_t start_;
+    size_t end_;
+};
+#endif // wxUSE_THREADS
+
+void wxPlotParallelFor(size_t count, size_t minCount,
+                       const std::function<void (size_t start, size_t end)> &func)
+{
+    size_t parts = 1;
+#if wxUSE_THREADS
+    int cpus = wxThread::GetCPUCount();
+    if ((cpus > 1) && (minCount > 0))
+        parts = wxMin(size_t(cpus), count/minCount);
+#endif // wxUSE_THREADS
+
+    if (parts <= 1)
+    {
+        if (count > 0)
+            func(0, count);
+        return;
+    }
+
+#if wxUSE_THREADS
+    // the first part is done on this thread, and any that can't get one
+    std::vector<wxPlotParallelThread*> threads;
+    for (size_t p = 1; p < parts; p++)
+    {
+        size_t start = p*count/parts, end = (p + 1)*count/parts;
+        wxPlotParallelThread *thread = new wxPlotParallelThread(func, start, end);
+        if (thread->Run() == wxTHREAD_NO_ERROR)
+            threads.push_back(thread);
+        else
+        {
+            delete thread;
+            func(start, end);
+        }
+    }
+
+    func(0, count/parts);
+
+    for (size_t t = 0; t < threads.size(); t++)
+    {
+        threads[t]->Wait();
+        delete threads[t];
+    }
+#endif // wxUSE_THREADS
+}
+
 //----------------------------------------------------------------------------
 // Interpolate
 //----------------------------------------------------------------------------
@@ -188,6 +276,54 @@ double LinearInterpolateY(double x0, double y0, double x1, double y1, double x)
     return (m*x + (y0 - m*x0));
 }
 
+// Find y at x along the segment (x0,y0)-(x1,y1) of x-ordered data, x is
+//   clamped to the segment and the ends are exact, used by GetY(x, index)
+//   and GetY(xs, ys, n) so they agree, no branches so loops of it vectorize
+static inline double InterpolateSegmentY(double x0, double y0,
+                                         double x1, double y1, double x)
+{
+    double t = (x - x0)/(x1 - x0);
+    t = (t > 0) ? t : 0;
+    t = (t < 1) ? t : 1;
+    return (y0 == y1) ? y0 : y0*(1 - t) + y1*t;
+}
+
+// Find the segment xs[i] <= x < xs[i+1] of x-ordered data with
+//   xs[0] <= x < xs[count-1], the search gallops out from the index given,
+//   or from where x would be if the points were evenly spaced if it's invalid
+static int FindXOrderedSegment(const double *xs, int count, double x, int index)
+{
+    int last = count - 2; // the last segment
+
+    if ((index < 0) || (index > last))
+        index = wxMin(int((x - xs[0])/(xs[count-1] - xs[0])*(count - 1)), last);
+
+    int lo, hi, step; // xs[lo] <= x < xs[hi]
+
+    if (xs[index] <= x)
+    {
+        for (lo = index, step = 1; ; step *= 2)
+        {
+            if (step > last - lo) { hi = last + 1; break; }
+            hi = lo + step;
+            if (x < xs[hi]) break;
+            lo = hi;
+        }
+    }
+    else
+    {
+        for (hi = index, step = 1; ; step *= 2)
+        {
+            if (step >= hi) { lo = 0; break; }
+            lo = hi - step;
+            if (xs[lo] <= x) break;
+            hi = lo;
+        }
+    }
+
+    return int(std::upper_bound(xs + lo + 1, xs + hi, x) - xs) - 1;
+}
+
 //-----------------------------------------------------------------------------
 // wxPlotData
 //-----------------------------------------------------------------------------
@@ -240,6 +376,24 @@ int wxPlotData::GetCount() const
     return M_PLOTDATA->count_;
 }
 
+unsigned long wxPlotData::GetDataVersion() const
+{
+    wxCHECK_MSG(Ok(), 0, wxT("Invalid wxPlotData"));
+    return M_PLOTDATA->dataVersion_;
+}
+
+bool wxPlotData::GetIsXOrdered() const
+{
+    wxCHECK_MSG(Ok(), false, wxT("Invalid wxPlotData"));
+    return M_PLOTDATA->xOrdered_;
+}
+
+unsigned long wxPlotData::GetPenVersion() const
+{
+    wxCHECK_MSG(Ok(), 0, wxT("Invalid wxPlotData"));
+    return M_PLOTDATA->penVersion_;
+}
+
 bool wxPlotData::Create(const wxPlotData& plotData)
 {
     wxCHECK_MSG(plotData.Ok(), false, wxT("Invalid wxPlotData"));
@@ -336,6 +490,7 @@ void wxPlotData::CalcBoundingRect()
     wxCHECK_RET(Ok(), wxT("Invalid wxPlotData"));
 
     M_PLOTDATA->boundingRect_ = wxNullPlotBounds;
+    M_PLOTDATA->dataVersion_ = ++wxPlotRefData::lastDataVersion_;
 
     double *xs = M_PLOTDATA->xs_,
            *ys = M_PLOTDATA->ys_;
@@ -349,6 +504,7 @@ void wxPlotData::CalcBoundingRect()
            xlast = x;
 
     bool valid = false;
+    bool ordered = true;
 
     int i, count = M_PLOTDATA->count_;
 
@@ -357,7 +513,11 @@ void wxPlotData::CalcBoundingRect()
         x = *xs++;
         y = *ys++;
 
-        if ((wxFinite(x) == 0) || (wxFinite(y) == 0)) continue;
+        if ((wxFinite(x) == 0) || (wxFinite(y) == 0))
+        {
+            ordered = false;
+            continue;
+        }
 
         if (!valid) // initialize the bounds
         {
@@ -373,10 +533,13 @@ void wxPlotData::CalcBoundingRect()
         if      (y < ymin) ymin = y;
         else if (y > ymax) ymax = y;
 
-        if (xlast <= x)
-            xlast = x;
+        if (x < xlast)
+            ordered = false;
+        xlast = x;
     }
 
+    M_PLOTDATA->xOrdered_ = ordered;
+
     if (valid)
         M_PLOTDATA->boundingRect_ = wxRect2DDouble(xmin, ymin, xmax-xmin, ymax-ymin);
     else
@@ -488,6 +651,100 @@ double wxPlotData::GetY(double x) const
                                M_PLOTDATA->xs_[i1], y1, x);
 }
 
+double wxPlotData::GetY(double x, int &index) const
+{
+    wxCHECK_MSG(Ok(), 0, wxT("invalid wxPlotData"));
+
+    if (!M_PLOTDATA->xOrdered_)
+        return GetY(x);
+
+    int count = M_PLOTDATA->count_;
+    const double *xs = M_PLOTDATA->xs_;
+    const double *ys = M_PLOTDATA->ys_;
+
+    // out of bounds, return the ends
+    if ((count < 2) || !(x > xs[0]))
+    {
+        index = 0;
+        return ys[0];
+    }
+    if (x >= xs[count-1])
+    {
+        index = count - 2;
+        return ys[count-1];
+    }
+
+    index = FindXOrderedSegment(xs, count, x, index);
+
+    return InterpolateSegmentY(xs[index], ys[index], xs[index+1], ys[index+1], x);
+}
+
+void wxPlotData::GetY(const double *xs, double *ys, size_t n) const
+{
+    wxCHECK_RET(Ok() && (n == 0 || (xs && ys)), wxT("Invalid wxPlotData"));
+
+    const int count = M_PLOTDATA->count_;
+    const double *dataXs = M_PLOTDATA->xs_;
+    const double *dataYs = M_PLOTDATA->ys_;
+
+    if (!M_PLOTDATA->xOrdered_ || (count < 2))
+    {
+        // each is a scan of the data, so the threads pay off for fewer
+        wxPlotParallelFor(n, wxMax(INTERPOLATE_PARALLEL_MIN/wxMax(count, 1), 1),
+            [&](size_t start, size_t end)
+            {
+                for (size_t i = start; i < end; i++)
+                    ys[i] = GetY(xs[i]);
+            });
+        return;
+    }
+
+    // large arrays are split between threads, each walks its part of the xs
+    wxPlotParallelFor(n, INTERPOLATE_PARALLEL_MIN, [&](size_t first, size_t last)
+    {
+        int segments[INTERPOLATE_BLOCK_SIZE];
+        double blockXs[INTERPOLATE_BLOCK_SIZE];
+        int index = -1;
+        size_t i;
+
+        for (size_t start = first; start < last; start += INTERPOLATE_BLOCK_SIZE)
+        {
+            size_t blockCount = wxMin(last - start, size_t(INTERPOLATE_BLOCK_SIZE));
+            const double *x = xs + start;
+
+            // ascending xs are next to the last segment, so this walks along
+            //   the data, x out of bounds is made infinite to give the ends
+            for (i = 0; i < blockCount; i++)
+            {
+                if (!(x[i] > dataXs[0]))
+                {
+                    segments[i] = 0;
+                    blockXs[i] = -HUGE_VAL;
+                }
+                else if (x[i] >= dataXs[count-1])
+                {
+                    segments[i] = count - 2;
+                    blockXs[i] = HUGE_VAL;
+                }
+                else
+                {
+                    index = FindXOrderedSegment(dataXs, count, x[i], index);
+                    segments[i] = index;
+                    blockXs[i] = x[i];
+                }
+            }
+
+            // no branches so the compiler can vectorize it
+            double *y = ys + start;
+            for (i = 0; i < blockCount; i++)
+            {
+                int s = segments[i];
+                y[i] = InterpolateSegmentY(dataXs[s], dataYs[s], dataXs[s+1], dataYs[s+1], blockXs[i]);
+            }
+        }
+    });
+}
+
 int wxPlotData::GetIndexFromX(double x, wxPlotData::IndexType type) const
 {
     wxCHECK_MSG(Ok(), 0, wxT("Invalid wxPlotData"));
@@ -571,6 +828,20 @@ int wxPlotData::GetIndexFromXY(double x, double y, double x_range) const
 
     int start = 1, end = M_PLOTDATA->count_ - 1;
 
+    // only the points within the x range need looking at if x is ordered
+    if ((x_range != 0) && M_PLOTDATA->xOrdered_)
+    {
+        const double *x_data = M_PLOTDATA->xs_;
+        int first = std::lower_bound(x_data, x_data + end + 1, x - x_range) - x_data;
+        int last  = std::upper_bound(x_data + first, x_data + end + 1, x + x_range) - x_data - 1;
+
+        if (first > last) // none in range, return the one next to it
+            return wxMin(first, end);
+
+        start = first + 1;
+        end   = last;
+    }
+
     int i, index = start - 1;
 
     double *xs = &M_PLOTDATA->xs_[index];
@@ -606,6 +877,70 @@ int wxPlotData::GetIndexFromXY(double x, double y, double x_range) const
     return index;
 }
 
+bool wxPlotData::GetSegmentFromXY(double x, double y, double dx, double dy,
+                                  int &index0, int &index1, double *t) const
+{
+    wxCHECK_MSG(Ok() && (dx > 0) && (dy > 0), false, wxT("Invalid wxPlotData"));
+
+    index0 = index1 = -1;
+
+    const double *xs = M_PLOTDATA->xs_;
+    const double *ys = M_PLOTDATA->ys_;
+    int count = M_PLOTDATA->count_;
+    if (count < 2) return false;
+
+    // the segments from start to end, if x is ordered only the ones
+    //   with a point in the x range and the two going into it can be near
+    int start = 0, end = count - 1;
+    if (M_PLOTDATA->xOrdered_)
+    {
+        start = int(std::lower_bound(xs, xs + count, x - dx) - xs) - 1;
+        end   = int(std::upper_bound(xs, xs + count, x + dx) - xs);
+        start = wxMax(start, 0);
+        end   = wxMin(end, count - 1);
+    }
+
+    // work in units of dx, dy from x, y
+    double u0 = (xs[start] - x)/dx, v0 = (ys[start] - y)/dy;
+    double min_dist = 0, min_t = 0;
+
+    for (int i = start; i < end; i++)
+    {
+        double u1 = (xs[i+1] - x)/dx, v1 = (ys[i+1] - y)/dy;
+
+        // skip it if both ends are off the same side of the box around x, y
+        if (!(((u0 > 1) && (u1 > 1)) || ((u0 < -1) && (u1 < -1)) ||
+              ((v0 > 1) && (v1 > 1)) || ((v0 < -1) && (v1 < -1))))
+        {
+            // the nearest point to 0, 0 is at u0 + s*du
+            double du = u1 - u0, dv = v1 - v0;
+            double len = du*du + dv*dv;
+            double s = (len > 0) ? -(u0*du + v0*dv)/len : 0;
+            s = wxMax(0.0, wxMin(1.0, s));
+
+            double pu = u0 + s*du, pv = v0 + s*dv;
+            double dist = pu*pu + pv*pv;
+
+            if ((dist <= 1) && ((index0 < 0) || (dist < min_dist)))
+            {
+                min_dist = dist;
+                min_t = s;
+                index0 = i;
+            }
+        }
+
+        u0 = u1;
+        v0 = v1;
+    }
+
+    if (index0 < 0)
+        return false;
+
+    index1 = index0 + 1;
+    if (t) *t = min_t;
+    return true;
+}
+
 //----------------------------------------------------------------------------
 // Get/Set bitmap symbol -- FIXME - this is NOT FINISHED OR WORKING
 //----------------------------------------------------------------------------
@@ -757,6 +1092,7 @@ void wxPlotData::SetPen(PenColorType type, const wxPen &pen)
     wxCHECK_RET(Ok(), wxT("invalid plotcurve"));
 
     M_PLOTCURVEDATA->pens_[PenColorType2Uint(type)] = pen;
+    M_PLOTCURVEDATA->penVersion_ = ++wxPlotRefData::lastDataVersion_;
 }
 
 wxPen wxPlotData::GetDefaultPen(PenColorType type)
@@ -11,6 +11,7 @@
 #include "wx/wx.h"
 #include "wx/math.h"
 #include "wx/dynarray.h"
+#include "wx/image.h"
 
 #include "wx/plotctrl/plotdraw.h"
 #include "wx/plotctrl/plotctrl.h"
@@ -20,6 +21,9 @@
 #include <math.h>
 #include <float.h>
 #include <limits.h>
+#include <string.h>
+
+#include <algorithm>
 
 // MSVC hogs global namespace with these min/max macros - remove them
 #ifdef max
@@ -355,6 +359,124 @@ int ClipLineToRect(double &x0, double &y0, double &x1, double &y1, const wxRect2
     return ret;
 }
 
+// ----------------------------------------------------------------------------
+// LineClipper - batch line clipping for polylines
+//
+// usage - Create a LineClipper(rect), OutCodes(...) for a block of points,
+//         then Clip(...) each segment with the outcodes of its two ends.
+//
+// The outcodes are computed in a tight loop without branches that the
+// compiler can vectorize, most segments are then trivially accepted or
+// rejected from them and only the ones crossing an edge are clipped using
+// Liang-Barsky. Non finite points get all the out bits so they're never
+// accepted.
+// ----------------------------------------------------------------------------
+
+#define CLIP_BLOCK_SIZE 256 // number of points to compute the outcodes of at once
+
+class LineClipper
+{
+public:
+    LineClipper() : m_left(0), m_right(0), m_top(0), m_bottom(0) {}
+    LineClipper(const wxRect2DDouble &rect) { SetRect(rect); }
+
+    void SetRect(const wxRect2DDouble &rect)
+    {
+        m_left   = rect.m_x;
+        m_right  = rect.GetRight();
+        m_top    = rect.m_y;
+        m_bottom = rect.GetBottom();
+    }
+
+    inline int OutCode(double x, double y) const
+    {
+        int nan = (x != x) | (y != y);
+        return (int(x < m_left)       * wxOutLeft)  | (int(x > m_right) * wxOutRight) |
+               (int(y < m_top)        * wxOutTop)   | (int(y > m_bottom) * wxOutBottom) |
+               (-nan & (wxOutLeft | wxOutRight | wxOutTop | wxOutBottom));
+    }
+
+    // Fill codes with the outcodes of the count points
+    void OutCodes(const double *x, const double *y, int count, int *codes) const
+    {
+        for (int i = 0; i < count; i++)
+            codes[i] = OutCode(x[i], y[i]);
+    }
+
+    // Clip the line (x0,y0)-(x1,y1) whose ends have the outcodes code0, code1
+    //   returns the ClipLine_Type of what was clipped, as ClipLineToRect
+    inline int Clip(double &x0, double &y0, double &x1, double &y1, int code0, int code1) const
+    {
+        if ((code0 | code1) == wxInside) return ClippedNeither; // both inside
+        if ((code0 & code1) != wxInside) return ClippedOut;     // both outside on same side
+        return ClipCrossing(x0, y0, x1, y1);
+    }
+
+    inline int Clip(double &x0, double &y0, double &x1, double &y1) const
+    {
+        return Clip(x0, y0, x1, y1, OutCode(x0, y0), OutCode(x1, y1));
+    }
+
+private:
+    // Liang-Barsky for a line that may cross an edge
+    int ClipCrossing(double &x0, double &y0, double &x1, double &y1) const;
+
+    double m_left, m_right, m_top, m_bottom;
+};
+
+int LineClipper::ClipCrossing(double &x0, double &y0, double &x1, double &y1) const
+{
+    if (!wxFinite(x0) || !wxFinite(y0) ||
+        !wxFinite(x1) || !wxFinite(y1)) return ClippedOut;
+
+    const double dx = x1 - x0;
+    const double dy = y1 - y0;
+    const double p[4] = { -dx, dx, -dy, dy };
+    const double q[4] = { x0 - m_left, m_right - x0, y0 - m_top, m_bottom - y0 };
+
+    double t0 = 0.0, t1 = 1.0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (p[i] == 0)
+        {
+            if (q[i] < 0) return ClippedOut; // parallel and outside of this edge
+        }
+        else
+        {
+            double t = q[i] / p[i];
+            if (p[i] < 0)
+            {
+                if (t > t1) return ClippedOut;
+                if (t > t0) t0 = t;
+            }
+            else
+            {
+                if (t < t0) return ClippedOut;
+                if (t < t1) t1 = t;
+            }
+        }
+    }
+
+    int ret = ClippedNeither;
+
+    // clip the second point first since it uses the original first point
+    if (t1 < 1.0)
+    {
+        x1 = x0 + t1 * dx;
+        y1 = y0 + t1 * dy;
+        ret |= ClippedSecond;
+    }
+    if (t0 > 0.0)
+    {
+        x0 = x0 + t0 * dx;
+        y0 = y0 + t0 * dy;
+        ret |= ClippedFirst;
+    }
+
+    return ret;
+}
+
 // ----------------------------------------------------------------------------
 // wxWindows spline drawing code see dcbase.cpp - inlined
 //
@@ -383,10 +505,11 @@ int ClipLineToRect(double &x0, double &y0, double &x1, double &y1, const wxRect2
 class SplineDrawer
 {
 public:
-    SplineDrawer() : m_dc(NULL) {}
+    SplineDrawer() : m_dc(NULL), m_selPen(NULL), m_curPen(NULL) {}
     // the wxRect2DDouble rect is the allowed dc area in pixel coords
     // wxRangeDoubleSelection is the ranges to use selPen, also in pixel coords
     // x1_, y1_, x2_, y2_ are the first 2 points to draw
+    // the pens aren't copied, they must outlive the drawing
     void Create(wxDC *dc, const wxPen &curPen, const wxPen &selPen,
                 const wxRect2DDouble &rect, wxRangeDoubleSelection *rangeSel,
                 double x1_, double y1_, double x2_, double y2_)
@@ -394,11 +517,12 @@ public:
         m_dc = dc;
         wxCHECK_RET(dc, wxT("invalid window dc"));
 
-        m_selPen   = selPen;
-        m_curPen   = curPen;
+        m_selPen   = &selPen;
+        m_curPen   = &curPen;
         m_rangeSel = rangeSel;
 
         m_rect = rect;
+        m_clipper.SetRect(rect);
 
         m_stack_count = 0;
 
@@ -415,14 +539,14 @@ public:
         m_last_y = m_y1;
     }
 
-    // actually do the drawing here
-    void DrawSpline(double x, double y);
+    // actually do the drawing here, isSelected is true if the dc has selPen
+    void DrawSpline(double x, double y, bool isSelected);
 
     // After the last point call this to finish the drawing
     void EndSpline()
     {
         wxCHECK_RET(m_dc, wxT("invalid window dc"));
-        if (ClipLineToRect(m_cx1, m_cy1, m_x2, m_y2, m_rect) != ClippedOut)
+        if (m_clipper.Clip(m_cx1, m_cy1, m_x2, m_y2) != ClippedOut)
             m_dc->DrawLine((int)m_cx1, (int)m_cy1, (int)m_x2, (int)m_y2);
     }
 
@@ -435,6 +559,7 @@ private:
 
     wxDC *m_dc;
     wxRect2DDouble m_rect;
+    LineClipper m_clipper;
 
     SplineStack m_splineStack[SPLINE_STACK_DEPTH];
     int m_stack_count;
@@ -443,16 +568,15 @@ private:
     double m_x1, m_y1, m_x2, m_y2;
     double m_last_x, m_last_y;
 
-    wxPen m_selPen, m_curPen;
+    const wxPen *m_selPen, *m_curPen;
     wxRangeDoubleSelection *m_rangeSel;
 };
 
-void SplineDrawer::DrawSpline(double x, double y)
+void SplineDrawer::DrawSpline(double x, double y, bool isSelected)
 {
     wxCHECK_RET(m_dc, wxT("invalid window dc"));
-    wxPen oldPen = m_dc->GetPen();
 
-    bool is_selected = (oldPen == m_selPen);
+    bool is_selected = isSelected;
 
     m_x1 = m_x2;
     m_y1 = m_y2;
@@ -485,15 +609,12 @@ void SplineDrawer::DrawSpline(double x, double y)
             double t1_last_y = m_last_y;
             double t1_xx1    = xx1;
             double t1_yy1    = yy1;
-            if (ClipLineToRect(t1_last_x, t1_last_y, t1_xx1, t1_yy1, m_rect) != ClippedOut)
+            if (m_clipper.Clip(t1_last_x, t1_last_y, t1_xx1, t1_yy1) != ClippedOut)
             {
                 if (m_rangeSel && (m_rangeSel->Contains((m_last_x + xx1)/2) != is_selected))
                 {
                     is_selected = is_selected ? false : true;
-                    if (is_selected)
-                        m_dc->SetPen(m_selPen);
-                    else
-                        m_dc->SetPen(m_curPen);
+                    m_dc->SetPen(is_selected ? *m_selPen : *m_curPen);
                 }
 
                 m_dc->DrawLine((int)t1_last_x, (int)t1_last_y, (int)t1_xx1, (int)t1_yy1);
@@ -503,15 +624,12 @@ void SplineDrawer::DrawSpline(double x, double y)
             double t2_yy1  = yy1;
             double t2_xmid = xmid;
             double t2_ymid = ymid;
-            if (ClipLineToRect(t2_xx1, t2_yy1, t2_xmid, t2_ymid, m_rect) != ClippedOut)
+            if (m_clipper.Clip(t2_xx1, t2_yy1, t2_xmid, t2_ymid) != ClippedOut)
             {
                 if (m_rangeSel && (m_rangeSel->Contains((xx1+xmid)/2) != is_selected))
                 {
                     is_selected = is_selected ? false : true;
-                    if (is_selected)
-                        m_dc->SetPen(m_selPen);
-                    else
-                        m_dc->SetPen(m_curPen);
+                    m_dc->SetPen(is_selected ? *m_selPen : *m_curPen);
                 }
 
                 m_dc->DrawLine((int)t2_xx1, (int)t2_yy1, (int)t2_xmid, (int)t2_ymid);
@@ -535,7 +653,132 @@ void SplineDrawer::DrawSpline(double x, double y)
     m_cx2 = (m_cx1 + m_x2) / 2.0;
     m_cy2 = (m_cy1 + m_y2) / 2.0;
 
-    m_dc->SetPen(oldPen);
+    if (is_selected != isSelected)
+        m_dc->SetPen(isSelected ? *m_selPen : *m_curPen);
+}
+
+// ----------------------------------------------------------------------------
+// SplineTessellator - the same subdivision as the SplineDrawer, but the points
+//   are kept in a wxPlotDrawerDataCurve::SplineCache in plot coords
+// ----------------------------------------------------------------------------
+
+#define SPLINE_CACHE_MAX_POINTS 1000000 // larger splines are drawn uncached
+
+#define DENSITY_SATURATION_COUNT 1000 // points on a pixel for the darkest colour
+#define DENSITY_MIN_ALPHA         96   // opacity of a pixel with a single point
+
+class SplineTessellator
+{
+public:
+    // scale_x, scale_y are the zoom, the pieces are about THRESHOLD pixels long
+    SplineTessellator(wxPlotDrawerDataCurve::SplineCache &cache, double scale_x, double scale_y)
+        : m_cache(cache), m_scale_x(scale_x), m_scale_y(scale_y), m_stack_count(0) {}
+
+    // returns false if it has more than SPLINE_CACHE_MAX_POINTS points
+    bool Create(const double *xs, const double *ys, int count);
+
+private:
+    struct SplineStack
+    {
+        double x1, y1, x2, y2, x3, y3, x4, y4;
+    };
+
+    void AddPoint(double x, double y, int index)
+    {
+        m_cache.xs_.push_back(x / m_scale_x);
+        m_cache.ys_.push_back(y / m_scale_y);
+        m_cache.index_.push_back(index);
+    }
+    bool Subdivide(double cx1, double cy1, double cx2, double cy2,
+                   double cx3, double cy3, double cx4, double cy4, int index);
+
+    wxPlotDrawerDataCurve::SplineCache &m_cache;
+    double m_scale_x, m_scale_y;
+
+    SplineStack m_splineStack[SPLINE_STACK_DEPTH];
+    int m_stack_count;
+};
+
+bool SplineTessellator::Create(const double *xs, const double *ys, int count)
+{
+    m_cache.xs_.clear();
+    m_cache.ys_.clear();
+    m_cache.index_.clear();
+    if (count < 2) return true;
+
+    double x1, y1;
+    double x2 = xs[0] * m_scale_x, y2 = ys[0] * m_scale_y;
+    AddPoint(x2, y2, 0);
+
+    x1 = x2; y1 = y2;
+    x2 = xs[1] * m_scale_x;
+    y2 = ys[1] * m_scale_y;
+    double cx1 = (x1  + x2) / 2.0, cy1 = (y1  + y2) / 2.0;
+    double cx2 = (cx1 + x2) / 2.0, cy2 = (cy1 + y2) / 2.0;
+
+    for (int n = 2; n < count; n++)
+    {
+        x1 = x2;
+        y1 = y2;
+        x2 = xs[n] * m_scale_x;
+        y2 = ys[n] * m_scale_y;
+        double cx4 = (x1 + x2) / 2.0, cy4 = (y1 + y2) / 2.0;
+        double cx3 = (x1 + cx4) / 2.0, cy3 = (y1 + cy4) / 2.0;
+
+        // this piece runs between the midpoints around point n-1
+        if (!Subdivide(cx1, cy1, cx2, cy2, cx3, cy3, cx4, cy4, n - 1))
+            return false;
+
+        cx1 = cx4;
+        cy1 = cy4;
+        cx2 = (cx1 + x2) / 2.0;
+        cy2 = (cy1 + y2) / 2.0;
+    }
+
+    // straight to the last point like SplineDrawer::EndSpline
+    AddPoint(x2, y2, count - 1);
+    return true;
+}
+
+bool SplineTessellator::Subdivide(double cx1, double cy1, double cx2, double cy2,
+                                  double cx3, double cy3, double cx4, double cy4, int index)
+{
+    double xmid, ymid;
+    double xx1, yy1, xx2, yy2, xx3, yy3, xx4, yy4;
+
+    SplineStack *stack_top = m_splineStack;
+    m_stack_count = 0;
+
+    SPLINE_PUSH(cx1, cy1, cx2, cy2, cx3, cy3, cx4, cy4);
+
+    while (m_stack_count > 0)
+    {
+        SPLINE_POP(xx1, yy1, xx2, yy2, xx3, yy3, xx4, yy4);
+
+        xmid = (xx2 + xx3)/2.0;
+        ymid = (yy2 + yy3)/2.0;
+
+        // NaNs never get flat, stop at the bottom of the stack for them
+        if (((fabs(xx1 - xmid) < THRESHOLD) && (fabs(yy1 - ymid) < THRESHOLD) &&
+             (fabs(xmid - xx4) < THRESHOLD) && (fabs(ymid - yy4) < THRESHOLD)) ||
+            (m_stack_count >= SPLINE_STACK_DEPTH - 2))
+        {
+            AddPoint(xx1, yy1, index);
+            AddPoint(xmid, ymid, index);
+
+            if (m_cache.xs_.size() > SPLINE_CACHE_MAX_POINTS)
+                return false;
+        }
+        else
+        {
+            SPLINE_PUSH(xmid, ymid, (xmid + xx3)/2.0, (ymid + yy3)/2.0,
+                        (xx3 + xx4)/2.0, (yy3 + yy4)/2.0, xx4, yy4);
+            SPLINE_PUSH(xx1, yy1, (xx1 + xx2)/2.0, (yy1 + yy2)/2.0,
+                        (xx2 + xmid)/2.0, (yy2 + ymid)/2.0, xmid, ymid);
+        }
+    }
+
+    return true;
 }
 
 //***************************************************************************
@@ -784,40 +1027,19 @@ void wxPlotDrawerKey::Draw(wxDC *dc, const wxString &keyString_)
 {
     wxCHECK_RET(dc && host_, wxT("Invalid dc"));
 
+    lastKeyRect_ = wxRect();
     if (keyString_.IsEmpty())
         return;
 
     wxString keyString = keyString_;
 
-    wxFont keyFont = font_;
-    if (fontScale_ != 1)
-        keyFont.SetPointSize(wxMax(2, RINT(keyFont.GetPointSize() * fontScale_)));
-
     int keyLineWidth  = RINT(keyLineWidth_  * penScale_);
     int keyLineMargin = RINT(keyLineMargin_ * penScale_);
 
-    dc->SetFont(keyFont);
-    dc->SetTextForeground(fontColour_);
-
-    wxRect keyRect;
     int heightLine = 0;
-
-    dc->GetMultiLineTextExtent(keyString, &keyRect.width, &keyRect.height, &heightLine);
-
-    wxRect dcRect(GetDCRect());
-    wxSize areaSize = dcRect.GetSize();
-
-    keyRect.x = 30 + int((keyPosition_.x*.01)*areaSize.x);
-    keyRect.y = areaSize.y - int((keyPosition_.y*.01)*areaSize.y);
-
-    if (keyInside_)
-    {
-        keyRect.x = wxMax(30, keyRect.x);
-        keyRect.x = wxMin(areaSize.x - keyRect.width - border_, keyRect.GetRight());
-
-        keyRect.y = wxMax(border_, keyRect.y);
-        keyRect.y = wxMin(areaSize.y - keyRect.height - border_, keyRect.y);
-    }
+    wxRect keyRect(CalcTextRect(dc, keyString, &heightLine));
+    dc->SetTextForeground(fontColour_);
+    lastKeyRect_ = GetKeyRect(dc, keyString);
 
     int h = keyRect.y;
     int i = 0;
@@ -850,6 +1072,61 @@ void wxPlotDrawerKey::Draw(wxDC *dc, const wxString &keyString_)
     dc->SetFont(wxNullFont);
 }
 
+wxRect wxPlotDrawerKey::CalcTextRect(wxDC *dc, const wxString &keyString, int *heightLine) const
+{
+    wxFont keyFont = font_;
+    if (fontScale_ != 1)
+        keyFont.SetPointSize(wxMax(2, RINT(keyFont.GetPointSize() * fontScale_)));
+
+    dc->SetFont(keyFont);
+
+    wxRect keyRect;
+    dc->GetMultiLineTextExtent(keyString, &keyRect.width, &keyRect.height, heightLine);
+
+    wxRect dcRect(GetDCRect());
+    wxSize areaSize = dcRect.GetSize();
+
+    keyRect.x = 30 + int((keyPosition_.x*.01)*areaSize.x);
+    keyRect.y = areaSize.y - int((keyPosition_.y*.01)*areaSize.y);
+
+    if (keyInside_)
+    {
+        keyRect.x = wxMax(30, keyRect.x);
+        keyRect.x = wxMin(areaSize.x - keyRect.width - border_, keyRect.GetRight());
+
+        keyRect.y = wxMax(border_, keyRect.y);
+        keyRect.y = wxMin(areaSize.y - keyRect.height - border_, keyRect.y);
+    }
+
+    return keyRect;
+}
+
+wxRect wxPlotDrawerKey::GetKeyRect(wxDC *dc, const wxString &keyString) const
+{
+    wxCHECK_MSG(dc && host_, wxRect(), wxT("Invalid dc"));
+
+    if (keyString.IsEmpty())
+        return wxRect();
+
+    int heightLine = 0;
+    wxRect keyRect(CalcTextRect(dc, keyString, &heightLine));
+
+    int keyLines = RINT((keyLineWidth_ + keyLineMargin_) * penScale_);
+
+    // the curve lines are at least 3 pixels wide
+    int penWidth = 3;
+    for (int i = 0; i < host_->GetCurveCount(); i++)
+        penWidth = wxMax(penWidth, int(host_->GetCurve(i)->GetPen(wxPlotData::PenColorType::NORMAL).GetWidth() * penScale_));
+
+    return wxRect(keyRect.x - keyLines - penWidth, keyRect.y - penWidth,
+                  keyRect.width + keyLines + 2*penWidth, keyRect.height + 2*penWidth);
+}
+
+const wxRect &wxPlotDrawerKey::GetLastKeyRect() const
+{
+    return lastKeyRect_;
+}
+
 void wxPlotDrawerKey::SetFont(const wxFont &font)
 {
     font_ = font;
@@ -865,110 +1142,339 @@ void wxPlotDrawerKey::SetKeyPosition(const wxPoint &pos)
     keyPosition_ = pos;
 }
 //-----------------------------------------------------------------------------
-// wxPlotDrawerDataCurve
+// wxPlotPickBuffer
 //-----------------------------------------------------------------------------
-IMPLEMENT_ABSTRACT_CLASS(wxPlotDrawerDataCurve, wxPlotDrawerBase)
-
-wxPlotDrawerDataCurve::wxPlotDrawerDataCurve(wxPlotCtrl* host):
-    wxPlotDrawerBase(host)
-{}
 
-void wxPlotDrawerDataCurve::Draw(wxDC *dc, wxPlotData *curve, int curveIndex)
+void wxPlotPickBuffer::Reset(const wxSize &size, const wxRect2DDouble &view,
+                             const wxPoint2DDouble &zoom)
 {
-    wxCHECK_RET(dc && host_ && curve && curve->Ok(), wxT("invalid curve"));
-    INITIALIZE_FAST_GRAPHICS
-
-    wxRect dcRect(GetDCRect());
+    size_ = size;
+    view_ = view;
+    zoom_ = zoom;
+    curves_.assign(size_t(wxMax(size.x, 0))*wxMax(size.y, 0), -1);
+    indexes_.resize(curves_.size());
+    others_.resize(curves_.size());
+}
 
-    wxRect2DDouble viewRect(GetPlotViewRect()); //viewRect_);
-    wxRect2DDouble subViewRect(host_->GetPlotRectFromClientRect(dcRect));
-    wxRect2DDouble curveRect(curve->GetBoundingRect());
-    if (!wxPlotRect2DDoubleIntersects(curveRect, subViewRect)) return;
+void wxPlotPickBuffer::Clear(const wxRect &rect)
+{
+    wxRect r(rect);
+    r.Intersect(wxRect(wxPoint(0, 0), size_));
 
-/*  // FIXME - drawing symbol bitmaps in MSW is very slow
-    wxBitmap bitmap;
-    if (curve == GetActiveCurve())
-        bitmap = curve->GetSymbol(wxPLOTPEN_ACTIVE);
-    else
-        bitmap = curve->GetSymbol(wxPLOTPEN_NORMAL);
+    for (int j = r.y; j < r.GetBottom() + 1; j++)
+        std::fill_n(curves_.begin() + size_t(j)*size_.x + r.x, r.width, -1);
+}
 
-    if (!bitmap.Ok())
+void wxPlotPickBuffer::Shift(int dx, int dy, const wxRect2DDouble &view)
+{
+    view_ = view;
+    if ((abs(dx) >= size_.x) || (abs(dy) >= size_.y))
     {
-        if (curve == GetActiveCurve())
-            bitmap = wxPlotSymbolCurrent;
-        else
-            bitmap = wxPlotSymbolNormal;
+        Clear(wxRect(wxPoint(0, 0), size_));
+        return;
     }
 
-    int bitmapHalfWidth = bitmap.GetWidth()/2;
-    int bitmapHalfHeight = bitmap.GetHeight()/2;
-*/
-
-    // find the starting and ending indexes into the data curve
-    int n, n_start = 0, n_end = curve->GetCount();
-
-    // set the pens to draw with
-    wxPen currentPen = (curveIndex == host_->GetActiveIndex()) ? curve->GetPen(wxPlotData::PenColorType::ACTIVE)
-                                                               : curve->GetPen(wxPlotData::PenColorType::NORMAL);
-    wxPen selectedPen = curve->GetPen(wxPlotData::PenColorType::SELECTED);
-    if (penScale_ != 1)
+    // rows are copied in the order that doesn't overwrite the ones to come
+    int width = size_.x - abs(dx);
+    int src_i = wxMax(-dx, 0), dst_i = wxMax(dx, 0);
+    for (int n = 0; n < size_.y - abs(dy); n++)
     {
-        currentPen.SetWidth(int(currentPen.GetWidth() * penScale_));
-        selectedPen.SetWidth(int(selectedPen.GetWidth() * penScale_));
+        int j = (dy > 0) ? size_.y - 1 - dy - n : -dy + n;
+        size_t src = size_t(j)*size_.x, dst = size_t(j + dy)*size_.x;
+        memmove(&curves_[dst + dst_i],  &curves_[src + src_i],  width*sizeof(int));
+        memmove(&indexes_[dst + dst_i], &indexes_[src + src_i], width*sizeof(int));
+        memmove(&others_[dst + dst_i],  &others_[src + src_i],  width*sizeof(int));
     }
 
-    dc->SetPen(currentPen);
+    if (dx != 0)
+        Clear(wxRect((dx > 0) ? 0 : size_.x + dx, 0, abs(dx), size_.y));
+    if (dy != 0)
+        Clear(wxRect(0, (dy > 0) ? 0 : size_.y + dy, size_.x, abs(dy)));
+}
 
-    // handle the selected ranges and initialize the starting range
-    const wxArrayRangeInt &ranges = host_->GetDataCurveSelection(curveIndex)->GetRangeArray();
-    int n_range = 0, range_count = ranges.GetCount();
-    int min_sel = -1, max_sel = -1;
-    for (n_range=0; n_range<range_count; n_range++)
+void wxPlotPickBuffer::SetLine(int i0, int j0, int i1, int j1, const wxRect &clip,
+                               int curve, int index0, int index1)
+{
+    // Bresenham, the same pixels as the line drawn closely enough
+    int di = abs(i1 - i0), dj = abs(j1 - j0);
+    int si = (i0 < i1) ? 1 : -1, sj = (j0 < j1) ? 1 : -1;
+    int steps = wxMax(di, dj), err = di - dj;
+
+    // lines from far outside are clipped to the view, not to the dc rect
+    if (((i0 < clip.x) && (i1 < clip.x)) || ((i0 > clip.GetRight()) && (i1 > clip.GetRight())) ||
+        ((j0 < clip.y) && (j1 < clip.y)) || ((j0 > clip.GetBottom()) && (j1 > clip.GetBottom())))
+        return;
+
+    for (int step = 0; step <= steps; step++)
     {
-        const wxRangeInt &range = ranges[n_range];
-        if ((range.m_max >= n_start) || (range.m_min >= n_start))
+        if (clip.Contains(i0, j0))
         {
-            min_sel = range.m_min;
-            max_sel = range.m_max;
-            if (range.Contains(n_start))
-                dc->SetPen(selectedPen);
-
-            break;
+            if (2*step < steps)
+                SetPixel(i0, j0, curve, index0, index1);
+            else
+                SetPixel(i0, j0, curve, index1, index0);
         }
-    }
-
-    // data variables
-    const double *x_data = &curve->GetXData()[n_start];
-    const double *y_data = &curve->GetYData()[n_start];
-
-    int i0, j0, i1, j1;        // curve coords in pixels
-    double x0, y0, x1, y1;     // original curve coords
-    double xx0, yy0, xx1, yy1; // clipped curve coords
-
-    x0 = *x_data;
-    y0 = *y_data;
 
-    int clipped = ClippedNeither;
+        int e2 = 2*err;
+        if (e2 > -dj) { err -= dj; i0 += si; }
+        if (e2 <  di) { err += di; j0 += sj; }
+    }
+}
 
-    const bool drawLines   = host_->GetDrawLines();
-    const bool drawSymbols = host_->GetDrawSymbols();
-    const bool drawSpline  = host_->GetDrawSpline();
+void wxPlotPickBuffer::SetDataVersion(int curve, unsigned long version)
+{
+    if ((int)dataVersions_.size() <= curve)
+        dataVersions_.resize(curve + 1, 0);
 
-    SplineDrawer sd;
-    wxRangeDoubleSelection dblRangeSel;
+    dataVersions_[curve] = version;
+}
 
-    if (drawSpline)
+bool wxPlotPickBuffer::Find(const wxPoint &pt, int radius, int &curve, int &index, int *other) const
+{
+    // the nearest of the pixels within radius, the first found in a ring
+    //   of them at the same distance wins
+    int best = -1, best_dist = 0;
+    for (int dj = -radius; dj <= radius; dj++)
     {
-        wxRangeDouble viewRange(viewRect.m_x, viewRect.GetRight());
+        int j = pt.y + dj;
+        if ((j < 0) || (j >= size_.y)) continue;
 
-        for (int r = n_range; r < range_count; r++)
+        for (int di = -radius; di <= radius; di++)
         {
-            wxRangeDouble plotRange(curve->GetXValue(ranges[r].m_min),
-                                    curve->GetXValue(ranges[r].m_max));
+            int i = pt.x + di;
+            if ((i < 0) || (i >= size_.x)) continue;
 
-            if (viewRange.Intersects(plotRange))
+            size_t p = size_t(j)*size_.x + i;
+            int dist = di*di + dj*dj;
+            if ((curves_[p] >= 0) && ((best < 0) || (dist < best_dist)))
             {
-                double min_x = host_->GetClientCoordFromPlotX(plotRange.m_min);
+                best = int(p);
+                best_dist = dist;
+            }
+        }
+    }
+
+    if (best < 0)
+        return false;
+
+    curve = curves_[best];
+    index = indexes_[best];
+    if (other)
+        *other = others_[best];
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// wxPlotDrawerDataCurve
+//-----------------------------------------------------------------------------
+IMPLEMENT_ABSTRACT_CLASS(wxPlotDrawerDataCurve, wxPlotDrawerBase)
+
+wxPlotDrawerDataCurve::wxPlotDrawerDataCurve(wxPlotCtrl* host):
+    wxPlotDrawerBase(host), pickBuffer_(NULL), partsEnd_(0), inParts_(false)
+{}
+
+void wxPlotDrawerDataCurve::Draw(wxDC *dc, wxPlotData *curve, int curveIndex)
+{
+    wxCHECK_RET(dc && host_ && curve && curve->Ok(), wxT("invalid curve"));
+    Draw(dc, curve, curveIndex, 0, curve->GetCount(), 1);
+}
+
+void wxPlotDrawerDataCurve::PixelMask::Reset(size_t pixels)
+{
+    // stamp 0 is never used, so memory set to 0 is clear
+    if ((marks_.size() != pixels) || (stamp_ >= (UINT_MAX >> 2)))
+    {
+        marks_.assign(pixels, 0);
+        stamp_ = 1;
+    }
+    else
+        stamp_++;
+}
+
+void wxPlotDrawerDataCurve::PixelCounts::Reset(size_t pixels)
+{
+    if (counts_.size() != pixels)
+        counts_.assign(pixels, 0);
+    else
+    {
+        for (size_t i = 0; i < touched_.size(); i++)
+            counts_[touched_[i]] = 0;
+    }
+
+    touched_.clear();
+}
+
+void wxPlotDrawerDataCurve::BeginParts()
+{
+    partsMask_.Reset(partsMask_.GetCount());
+    partsCounts_.Reset(partsCounts_.GetCount());
+    partsEnd_ = 0;
+}
+
+void wxPlotDrawerDataCurve::DrawPart(wxDC *dc, wxPlotData *curve, int curveIndex,
+                                     int startIndex, int endIndex)
+{
+    inParts_ = true;
+    Draw(dc, curve, curveIndex, startIndex, endIndex, 1);
+    inParts_ = false;
+    partsEnd_ = wxMax(partsEnd_, endIndex);
+}
+
+void wxPlotDrawerDataCurve::EndParts(wxDC *dc, wxPlotData *curve, int curveIndex)
+{
+    if (!partsCounts_.touched_.empty())
+        DrawDensityMap(dc, curve, curveIndex, partsCounts_, partsMask_);
+
+    BeginParts();
+}
+
+void wxPlotDrawerDataCurve::Draw(wxDC *dc, wxPlotData *curve, int curveIndex,
+                                 int startIndex, int endIndex, int stride)
+{
+    wxCHECK_RET(dc && host_ && curve && curve->Ok(), wxT("invalid curve"));
+    wxCHECK_RET((startIndex >= 0) && (startIndex < endIndex) && (endIndex <= (int)curve->GetCount()) &&
+                (stride > 0), wxT("invalid data index"));
+    INITIALIZE_FAST_GRAPHICS
+
+    wxRect dcRect(GetDCRect());
+
+    wxRect2DDouble viewRect(GetPlotViewRect()); //viewRect_);
+    wxRect2DDouble subViewRect(host_->GetPlotRectFromClientRect(dcRect));
+    wxRect2DDouble curveRect(curve->GetBoundingRect());
+    if (!wxPlotRect2DDoubleIntersects(curveRect, subViewRect)) return;
+
+    if (pickBuffer_)
+        pickBuffer_->SetDataVersion(curveIndex, curve->GetDataVersion());
+
+    if (host_->GetDrawDensity())
+    {
+        DrawDensity(dc, curve, curveIndex, startIndex, endIndex, stride);
+        return;
+    }
+
+/*  // FIXME - drawing symbol bitmaps in MSW is very slow
+    wxBitmap bitmap;
+    if (curve == GetActiveCurve())
+        bitmap = curve->GetSymbol(wxPLOTPEN_ACTIVE);
+    else
+        bitmap = curve->GetSymbol(wxPLOTPEN_NORMAL);
+
+    if (!bitmap.Ok())
+    {
+        if (curve == GetActiveCurve())
+            bitmap = wxPlotSymbolCurrent;
+        else
+            bitmap = wxPlotSymbolNormal;
+    }
+
+    int bitmapHalfWidth = bitmap.GetWidth()/2;
+    int bitmapHalfHeight = bitmap.GetHeight()/2;
+*/
+
+    // find the starting and ending indexes into the data curve
+    int n, n_start = startIndex, n_end = endIndex;
+
+    // set the pens to draw with
+    const PenCache &penCache = GetPenCache(curve, curveIndex);
+    const wxPen &currentPen = penCache.pens_[(curveIndex == host_->GetActiveIndex()) ? 1 : 0];
+    const wxPen &selectedPen = penCache.pens_[2];
+    bool penSelected = false; // which of the two the dc has
+
+    dc->SetPen(currentPen);
+
+    // segments entirely outside of the dc rect, plus room for the pen and
+    // symbols, are skipped. They're still clipped to the whole view so the
+    // pixels drawn don't depend on the size of the dc rect.
+    int margin = wxMax(currentPen.GetWidth(), selectedPen.GetWidth()) + 4;
+    wxRect2DDouble drawRect(host_->GetPlotRectFromClientRect(wxRect(dcRect).Inflate(margin)));
+
+    // handle the selected ranges and initialize the starting range
+    const wxRangeIntSelection *selection = host_->GetDataCurveSelection(curveIndex);
+    wxRangeInt sel_range;
+    int min_sel = -1, max_sel = -1;
+    if (selection->NextRange(n_start, sel_range))
+    {
+        min_sel = sel_range.m_min;
+        max_sel = sel_range.m_max;
+        if (sel_range.Contains(n_start))
+        {
+            dc->SetPen(selectedPen);
+            penSelected = true;
+        }
+    }
+
+    // data variables
+    const double *x_data = &curve->GetXData()[n_start];
+    const double *y_data = &curve->GetYData()[n_start];
+
+    int i0, j0, i1, j1;        // curve coords in pixels
+    double x0, y0, x1, y1;     // original curve coords
+    double xx0, yy0, xx1, yy1; // clipped curve coords
+
+    x0 = *x_data;
+    y0 = *y_data;
+
+    int clipped = ClippedNeither;
+
+    // outcodes and pixel coords of a block of points against the view and the dc rect
+    LineClipper viewClipper(viewRect), drawClipper(drawRect);
+    int viewCodes[CLIP_BLOCK_SIZE], drawCodes[CLIP_BLOCK_SIZE];
+    int viewCode0 = viewClipper.OutCode(x0, y0), viewCode1;
+    int drawCode0 = drawClipper.OutCode(x0, y0), drawCode1;
+    int blockX[CLIP_BLOCK_SIZE], blockY[CLIP_BLOCK_SIZE];
+    int pi0 = host_->GetClientCoordFromPlotX(x0), pi1;
+    int pj0 = host_->GetClientCoordFromPlotY(y0), pj1;
+    int block = 0, block_count = 0;
+
+    // a decimated preview skips the symbols and the spline
+    const bool drawLines   = host_->GetDrawLines();
+    const bool drawSymbols = host_->GetDrawSymbols() && (stride == 1);
+    bool drawSpline = host_->GetDrawSpline() && (stride == 1);
+
+    // a spline can't be seen with more than one point per pixel
+    if (drawSpline && (curveRect.m_width > 0))
+    {
+        double visible = wxMin(curveRect.GetRight(), viewRect.GetRight()) -
+                         wxMax(curveRect.GetLeft(),  viewRect.GetLeft());
+        if (curve->GetCount() * visible / curveRect.m_width > host_->GetPlotAreaRect().width)
+            drawSpline = false;
+    }
+
+    // each pixel gets at most one symbol of each pen, bit 1 normal, 2 selected,
+    //   the parts of a curve drawn with DrawPart share the mask
+    PixelMask &symbolMask = inParts_ ? partsMask_ : pixelMask_;
+    size_t pixels = size_t(wxMax(dcRect.width, 0))*wxMax(dcRect.height, 0);
+    if (drawSymbols && (!inParts_ || (symbolMask.GetCount() != pixels)))
+        symbolMask.Reset(pixels);
+
+    // the whole spline is cached for the zoom, parts of it are drawn directly
+    const SplineCache *splineCache = NULL;
+    if (drawSpline && (n_start == 0) && (n_end == (int)curve->GetCount()))
+        splineCache = GetSplineCache(curve, curveIndex);
+    double strideX[CLIP_BLOCK_SIZE], strideY[CLIP_BLOCK_SIZE];
+
+    // a preview only draws the ends and the extremes of each pixel column
+    if (stride > 1)
+        GetPreviewIndexes(curve, n_start, n_end, stride, previewIndexes_);
+    const int point_count = (stride > 1) ? int(previewIndexes_.size()) : n_end - n_start;
+    int n_prev = n_start - 1; // the point drawn before n
+
+    SplineDrawer sd;
+    wxRangeDoubleSelection dblRangeSel;
+
+    if (drawSpline && !splineCache)
+    {
+        wxRangeDouble viewRange(viewRect.m_x, viewRect.GetRight());
+
+        wxRangeInt r;
+        for (int i = n_start; selection->NextRange(i, r); i = r.m_max + 1)
+        {
+            wxRangeDouble plotRange(curve->GetXValue(r.m_min),
+                                    curve->GetXValue(r.m_max));
+
+            if (viewRange.Intersects(plotRange))
+            {
+                double min_x = host_->GetClientCoordFromPlotX(plotRange.m_min);
                 double max_x = host_->GetClientCoordFromPlotX(plotRange.m_max);
                 dblRangeSel.SelectRange(wxRangeDouble(min_x, max_x));
             }
@@ -987,72 +1493,521 @@ void wxPlotDrawerDataCurve::Draw(wxDC *dc, wxPlotData *curve, int curveIndex)
                   host_->GetClientCoordFromPlotY(y_data[s_start+1]));
     }
 
-    for (n = n_start; n < n_end; n++)
+    for (int p = 0; p < point_count; p++)
     {
-        x1 = *x_data++;
-        y1 = *y_data++;
+        n = (stride > 1) ? previewIndexes_[p] : n_start + p;
+
+        if (block == block_count)
+        {
+            const double *block_x = &x_data[n - n_start], *block_y = &y_data[n - n_start];
+            block_count = wxMin(CLIP_BLOCK_SIZE, point_count - p);
+            if (stride > 1)
+            {
+                for (int k = 0; k < block_count; k++)
+                {
+                    strideX[k] = x_data[previewIndexes_[p + k] - n_start];
+                    strideY[k] = y_data[previewIndexes_[p + k] - n_start];
+                }
+                block_x = strideX;
+                block_y = strideY;
+            }
+            viewClipper.OutCodes(block_x, block_y, block_count, viewCodes);
+            drawClipper.OutCodes(block_x, block_y, block_count, drawCodes);
+            host_->GetClientCoordsFromPlotX(block_x, blockX, block_count);
+            host_->GetClientCoordsFromPlotY(block_y, blockY, block_count);
+            block = 0;
+        }
+
+        viewCode1 = viewCodes[block];
+        drawCode1 = drawCodes[block];
+        pi1 = blockX[block];
+        pj1 = blockY[block];
+        block++;
+
+        x1 = x_data[n - n_start];
+        y1 = y_data[n - n_start];
+
+        // a selection starts at this point or at one skipped over since the last
+        const bool selStart = (min_sel >= 0) && (n >= min_sel) && (n_prev < min_sel);
 
-        if (drawSpline)
-            sd.DrawSpline(host_->GetClientCoordFromPlotX(x1),
-                          host_->GetClientCoordFromPlotY(y1));
+        if (drawSpline && !splineCache)
+            sd.DrawSpline(pi1, pj1, penSelected);
 
         xx0 = x0; yy0 = y0; xx1 = x1; yy1 = y1;
-        clipped = ClipLineToRect(xx0, yy0, xx1, yy1, viewRect);
+        if ((drawCode0 & drawCode1) != wxInside)
+            clipped = ClippedOut;
+        else
+            clipped = viewClipper.Clip(xx0, yy0, xx1, yy1, viewCode0, viewCode1);
+
         if (clipped != ClippedOut)
         {
-            i0 = host_->GetClientCoordFromPlotX(xx0);
-            j0 = host_->GetClientCoordFromPlotY(yy0);
-            i1 = host_->GetClientCoordFromPlotX(xx1);
-            j1 = host_->GetClientCoordFromPlotY(yy1);
+            // only the clipped ends need converting, the rest are in the block
+            if ((clipped & ClippedFirst) != 0)
+            {
+                i0 = host_->GetClientCoordFromPlotX(xx0);
+                j0 = host_->GetClientCoordFromPlotY(yy0);
+            }
+            else
+            {
+                i0 = pi0;
+                j0 = pj0;
+            }
+            if ((clipped & ClippedSecond) != 0)
+            {
+                i1 = host_->GetClientCoordFromPlotX(xx1);
+                j1 = host_->GetClientCoordFromPlotY(yy1);
+            }
+            else
+            {
+                i1 = pi1;
+                j1 = pj1;
+            }
 
             if (drawLines && ((i0 != i1) || (j0 != j1)))
             {
                 wxPLOTCTRL_DRAW_LINE(dc, window, pen, i0, j0, i1, j1);
             }
 
-            if (n == min_sel)
+            // the pixels of the line from the last point are picked as the
+            //   nearer of the two, the spline is picked as the straight line
+            if (pickBuffer_ && drawLines)
+                pickBuffer_->SetLine(i0, j0, i1, j1, dcRect, curveIndex, wxMax(n_prev, n_start), n);
+
+            if (selStart)
+            {
                 dc->SetPen(selectedPen);
+                penSelected = true;
+            }
 
-            if (drawSymbols && !((clipped & ClippedSecond) != 0) &&
-                ((i0 != i1) || (j0 != j1) || (n == min_sel) || (n == n_start)))
+            if (drawSymbols && !((clipped & ClippedSecond) != 0))
             {
+                bool stamp = true;
+                int mi = i1 - dcRect.x, mj = j1 - dcRect.y;
+                if ((mi >= 0) && (mi < dcRect.width) && (mj >= 0) && (mj < dcRect.height))
+                {
+                    unsigned int bit = penSelected ? 2 : 1;
+                    size_t pixel = size_t(mj)*dcRect.width + mi;
+                    stamp = (symbolMask.Get(pixel) & bit) == 0;
+                    symbolMask.Set(pixel, bit);
+                }
+
                 //dc->DrawBitmap(bitmap, i1 - bitmapHalfWidth, j1 - bitmapHalfHeight, true);
-                wxPLOTCTRL_DRAW_ELLIPSE(dc, window, pen, i1, j1, 2, 2);
+                if (stamp)
+                    wxPLOTCTRL_DRAW_ELLIPSE(dc, window, pen, i1, j1, 2, 2);
+
+                if (pickBuffer_ && dcRect.Contains(i1, j1))
+                    pickBuffer_->SetPixel(i1, j1, curveIndex, n);
             }
         }
-        else if (n == min_sel)
+        else if (selStart)
         {
             dc->SetPen(selectedPen);
+            penSelected = true;
         }
 
-        if (n == max_sel)
+        if ((max_sel >= 0) && (n >= max_sel))
         {
-            dc->SetPen(currentPen);
-            if (n_range < range_count - 1)
+            // a preview may step over whole ranges
+            if (selection->NextRange(n + 1, sel_range))
             {
-                n_range++;
-                min_sel = ranges[n_range].m_min;
-                max_sel = ranges[n_range].m_max;
+                min_sel = sel_range.m_min;
+                max_sel = sel_range.m_max;
+            }
+            else
+                min_sel = max_sel = -1; // no ranges left
+
+            bool sel = (min_sel >= 0) && (n >= min_sel);
+            if (sel != penSelected)
+            {
+                penSelected = sel;
+                dc->SetPen(penSelected ? selectedPen : currentPen);
             }
         }
 
         x0 = x1;
         y0 = y1;
+        viewCode0 = viewCode1;
+        drawCode0 = drawCode1;
+        pi0 = pi1;
+        pj0 = pj1;
+        n_prev = n;
     }
 
-    if (drawSpline)
+    if (drawSpline && !splineCache)
     {
         // want an extra point at the end to smooth it out
         if (n_end < (int)curve->GetCount() - 1)
-            sd.DrawSpline(host_->GetClientCoordFromPlotX(*x_data),
-                          host_->GetClientCoordFromPlotY(*y_data));
+            sd.DrawSpline(host_->GetClientCoordFromPlotX(x_data[n_end - n_start]),
+                          host_->GetClientCoordFromPlotY(y_data[n_end - n_start]), penSelected);
 
         sd.EndSpline();
     }
 
+    if (splineCache)
+        DrawSplineCache(dc, *splineCache, curveIndex, currentPen, selectedPen, viewRect, drawRect);
+
     dc->SetPen(wxNullPen);
 }
 
+void wxPlotDrawerDataCurve::GetPreviewIndexes(wxPlotData *curve, int startIndex, int endIndex,
+                                              int stride, std::vector<int> &indexes)
+{
+    indexes.clear();
+    wxCHECK_RET(host_ && curve && curve->Ok() && (startIndex < endIndex), wxT("invalid curve"));
+
+    const double *x_data = curve->GetXData();
+    const double *y_data = curve->GetYData();
+    const bool ordered = curve->GetIsXOrdered();
+    int columns[CLIP_BLOCK_SIZE];
+    int column = 0, first = startIndex, lo = startIndex, hi = startIndex;
+
+    // in index order so the lines between them follow the curve
+    auto addBucket = [&](int last)
+    {
+        const int bucket[4] = { first, wxMin(lo, hi), wxMax(lo, hi), last };
+        for (int k = 0; k < 4; k++)
+        {
+            if (indexes.empty() || (bucket[k] > indexes.back()))
+                indexes.push_back(bucket[k]);
+        }
+    };
+
+    for (int n = startIndex; n < endIndex; n += CLIP_BLOCK_SIZE)
+    {
+        int count = wxMin(CLIP_BLOCK_SIZE, endIndex - n);
+        if (ordered)
+            host_->GetClientCoordsFromPlotX(&x_data[n], columns, count);
+
+        for (int k = 0; k < count; k++)
+        {
+            // the points of x-ordered data are bucketed by pixel column,
+            //   others can go anywhere so they're taken stride at a time
+            int i = n + k;
+            bool next = ordered ? ((i > startIndex) && (columns[k] != column))
+                                : ((i > startIndex) && ((i - startIndex) % stride == 0));
+            if (ordered)
+                column = columns[k];
+
+            if (next)
+            {
+                addBucket(i - 1);
+                first = lo = hi = i;
+            }
+
+            if (y_data[i] < y_data[lo]) lo = i;
+            if (y_data[i] > y_data[hi]) hi = i;
+        }
+    }
+
+    addBucket(endIndex - 1);
+}
+
+void wxPlotDrawerDataCurve::DrawDensity(wxDC *dc, wxPlotData *curve, int curveIndex,
+                                        int startIndex, int endIndex, int stride)
+{
+    wxCHECK_RET(dc && host_ && curve && curve->Ok(), wxT("invalid curve"));
+
+    wxRect dcRect(GetDCRect());
+    if ((dcRect.width <= 0) || (dcRect.height <= 0)) return;
+
+    // count the points on each pixel, the mask marks those with selected
+    //   ones, the parts of a curve add up and the first point of each is
+    //   the last one of the part before
+    size_t pixels = size_t(dcRect.width)*dcRect.height;
+    PixelCounts &counts = inParts_ ? partsCounts_ : pixelCounts_;
+    PixelMask &mask = inParts_ ? partsMask_ : pixelMask_;
+    if (!inParts_ || (counts.GetCount() != pixels))
+    {
+        counts.Reset(pixels);
+        mask.Reset(pixels);
+    }
+    else if (startIndex < partsEnd_)
+        startIndex = partsEnd_;
+
+    const wxRangeIntSelection *selection = host_->GetDataCurveSelection(curveIndex);
+    wxRangeInt sel_range;
+    bool more_sel = selection->NextRange(startIndex, sel_range);
+
+    const double *x_data = curve->GetXData();
+    const double *y_data = curve->GetYData();
+    double strideX[CLIP_BLOCK_SIZE], strideY[CLIP_BLOCK_SIZE];
+    int blockX[CLIP_BLOCK_SIZE], blockY[CLIP_BLOCK_SIZE];
+
+    for (int n = startIndex; n < endIndex; n += CLIP_BLOCK_SIZE*stride)
+    {
+        int k, count = wxMin(CLIP_BLOCK_SIZE, (endIndex - n + stride - 1)/stride);
+        const double *block_x = &x_data[n], *block_y = &y_data[n];
+        if (stride > 1)
+        {
+            for (k = 0; k < count; k++)
+            {
+                strideX[k] = block_x[k*stride];
+                strideY[k] = block_y[k*stride];
+            }
+            block_x = strideX;
+            block_y = strideY;
+        }
+
+        host_->GetClientCoordsFromPlotX(block_x, blockX, count);
+        host_->GetClientCoordsFromPlotY(block_y, blockY, count);
+
+        for (k = 0; k < count; k++)
+        {
+            int i = blockX[k] - dcRect.x, j = blockY[k] - dcRect.y;
+            if ((i < 0) || (i >= dcRect.width) || (j < 0) || (j >= dcRect.height))
+                continue;
+
+            // a decimated point stands for the ones skipped
+            size_t pixel = size_t(j)*dcRect.width + i;
+            counts.Add(pixel, stride);
+
+            int index = n + k*stride;
+            if (more_sel && (sel_range.m_max < index))
+                more_sel = selection->NextRange(index, sel_range);
+            if (more_sel && (sel_range.m_min <= index))
+                mask.Set(pixel, 1);
+            if (pickBuffer_)
+                pickBuffer_->SetPixel(blockX[k], blockY[k], curveIndex, index);
+        }
+    }
+
+    // the parts are drawn together by EndParts
+    if (!inParts_)
+        DrawDensityMap(dc, curve, curveIndex, counts, mask);
+}
+
+void wxPlotDrawerDataCurve::DrawDensityMap(wxDC *dc, wxPlotData *curve, int curveIndex,
+                                           const PixelCounts &counts, const PixelMask &mask)
+{
+    wxCHECK_RET(dc && host_ && curve && curve->Ok(), wxT("invalid curve"));
+
+    wxRect dcRect(GetDCRect());
+    size_t pixels = size_t(wxMax(dcRect.width, 0))*wxMax(dcRect.height, 0);
+    if ((pixels == 0) || (counts.GetCount() != pixels) || (mask.GetCount() != pixels) ||
+        counts.touched_.empty())
+    {
+        return;
+    }
+
+    // only the part of the rect with counts is drawn
+    int left = dcRect.width, right = -1, top = dcRect.height, bottom = -1;
+    for (size_t t = 0; t < counts.touched_.size(); t++)
+    {
+        int i = int(counts.touched_[t] % dcRect.width), j = int(counts.touched_[t] / dcRect.width);
+        left = wxMin(left, i); right = wxMax(right, i);
+        top = wxMin(top, j);   bottom = wxMax(bottom, j);
+    }
+
+    // the pen colour from light and faint for a single point to dark and
+    //   opaque at DENSITY_SATURATION_COUNT, on a log scale that doesn't
+    //   depend on the other counts so the density maps of different rects
+    //   match up and overlapping curves keep their colours
+    const PenCache &penCache = GetPenCache(curve, curveIndex);
+    const wxPen &pen = penCache.pens_[(curveIndex == host_->GetActiveIndex()) ? 1 : 0];
+    const unsigned char colour[3] = { pen.GetColour().Red(), pen.GetColour().Green(), pen.GetColour().Blue() };
+    unsigned char palette[256][4];
+    for (int c = 0; c < 256; c++)
+    {
+        double t = c/255.0;
+        for (int k = 0; k < 3; k++)
+        {
+            double light = colour[k] + (255 - colour[k])*0.75, dark = colour[k]*0.5;
+            double v = (t < 0.5) ? light + (colour[k] - light)*2*t : colour[k] + (dark - colour[k])*(2*t - 1);
+            palette[c][k] = (unsigned char)(v + 0.5);
+        }
+        palette[c][3] = (unsigned char)(DENSITY_MIN_ALPHA + (255 - DENSITY_MIN_ALPHA)*t + 0.5);
+    }
+
+    const wxColour selectedColour(penCache.pens_[2].GetColour());
+    const double scale = 255/log(double(DENSITY_SATURATION_COUNT));
+
+    const int width = right - left + 1, height = bottom - top + 1;
+    wxImage image(width, height, false);
+    image.InitAlpha();
+    unsigned char *rgb = image.GetData();
+    unsigned char *alpha = image.GetAlpha();
+
+    for (int j = top; j <= bottom; j++)
+    {
+        size_t p = size_t(j)*dcRect.width + left;
+        for (int i = left; i <= right; i++, p++, rgb += 3, alpha++)
+        {
+            unsigned int hits = counts.counts_[p];
+            if (hits == 0)
+            {
+                *alpha = 0;
+                continue;
+            }
+
+            if (mask.Get(p))
+            {
+                rgb[0] = selectedColour.Red();
+                rgb[1] = selectedColour.Green();
+                rgb[2] = selectedColour.Blue();
+                *alpha = 255;
+                continue;
+            }
+
+            int c = (hits >= DENSITY_SATURATION_COUNT) ? 255 : (hits <= 1) ? 0 : int(log(double(hits))*scale);
+            rgb[0] = palette[c][0];
+            rgb[1] = palette[c][1];
+            rgb[2] = palette[c][2];
+            *alpha = palette[c][3];
+        }
+    }
+
+    dc->DrawBitmap(wxBitmap(image), dcRect.x + left, dcRect.y + top, true);
+}
+
+const wxPlotDrawerDataCurve::PenCache &wxPlotDrawerDataCurve::GetPenCache(wxPlotData *curve, int curveIndex)
+{
+    wxASSERT(curve && curve->Ok() && (curveIndex >= 0));
+
+    if ((int)penCaches_.size() <= curveIndex)
+        penCaches_.resize(curveIndex + 1);
+
+    PenCache &cache = penCaches_[curveIndex];
+
+    if ((cache.penVersion_ != curve->GetPenVersion()) || (cache.penScale_ != penScale_))
+    {
+        cache.penVersion_ = curve->GetPenVersion();
+        cache.penScale_ = penScale_;
+
+        const wxPlotData::PenColorType types[3] = { wxPlotData::PenColorType::NORMAL,
+                                                    wxPlotData::PenColorType::ACTIVE,
+                                                    wxPlotData::PenColorType::SELECTED };
+        for (int i = 0; i < 3; i++)
+        {
+            cache.pens_[i] = curve->GetPen(types[i]);
+            if (penScale_ != 1)
+                cache.pens_[i].SetWidth(int(cache.pens_[i].GetWidth() * penScale_));
+        }
+    }
+
+    return cache;
+}
+
+const wxPlotDrawerDataCurve::SplineCache *wxPlotDrawerDataCurve::GetSplineCache(wxPlotData *curve, int curveIndex)
+{
+    wxCHECK_MSG(host_ && curve && curve->Ok() && (curveIndex >= 0), NULL, wxT("invalid curve"));
+
+    if ((int)splineCaches_.size() <= curveIndex)
+        splineCaches_.resize(curveIndex + 1);
+
+    SplineCache &cache = splineCaches_[curveIndex];
+    const wxPoint2DDouble &zoom = host_->GetZoom();
+
+    // keep it until the zoom changes by more than a factor of 2, the pieces
+    //   are then still between THRESHOLD/2 and 2*THRESHOLD pixels long
+    auto rezoomed = [](double a, double b) { return (a > 2*b) || (b > 2*a); };
+
+    if ((cache.dataVersion_ != curve->GetDataVersion()) ||
+        rezoomed(zoom.m_x, cache.zoom_.m_x) || rezoomed(zoom.m_y, cache.zoom_.m_y))
+    {
+        cache.dataVersion_ = curve->GetDataVersion();
+        cache.zoom_ = zoom;
+
+        SplineTessellator tessellator(cache, zoom.m_x, zoom.m_y);
+        cache.tooLarge_ = !tessellator.Create(curve->GetXData(), curve->GetYData(), curve->GetCount());
+        if (cache.tooLarge_)
+        {
+            std::vector<double>().swap(cache.xs_);
+            std::vector<double>().swap(cache.ys_);
+            std::vector<int>().swap(cache.index_);
+        }
+    }
+
+    return cache.tooLarge_ ? NULL : &cache;
+}
+
+void wxPlotDrawerDataCurve::DrawSplineCache(wxDC *dc, const SplineCache &cache, int curveIndex,
+                                            const wxPen &currentPen, const wxPen &selectedPen,
+                                            const wxRect2DDouble &viewRect, const wxRect2DDouble &drawRect)
+{
+    wxCHECK_RET(dc && host_, wxT("invalid dc"));
+    INITIALIZE_FAST_GRAPHICS
+
+    int k, count = cache.xs_.size();
+    if (count < 2) return;
+
+    // the pieces are in data order, so are the selected ranges
+    const wxRangeIntSelection *selection = host_->GetDataCurveSelection(curveIndex);
+    wxRangeInt sel_range;
+    bool more_sel = selection->NextRange(cache.index_[0], sel_range);
+    bool selected = false;
+    dc->SetPen(currentPen);
+
+    const double *xs = &cache.xs_[0];
+    const double *ys = &cache.ys_[0];
+    double x0 = xs[0], y0 = ys[0], x1, y1;
+    double xx0, yy0, xx1, yy1;
+    int i0, j0, i1, j1;
+
+    LineClipper viewClipper(viewRect), drawClipper(drawRect);
+    int viewCodes[CLIP_BLOCK_SIZE], drawCodes[CLIP_BLOCK_SIZE];
+    int viewCode0 = viewClipper.OutCode(x0, y0), viewCode1;
+    int drawCode0 = drawClipper.OutCode(x0, y0), drawCode1;
+    int blockX[CLIP_BLOCK_SIZE], blockY[CLIP_BLOCK_SIZE];
+    int pi0 = host_->GetClientCoordFromPlotX(x0), pi1;
+    int pj0 = host_->GetClientCoordFromPlotY(y0), pj1;
+    int block = 0, block_count = 0;
+
+    for (k = 1; k < count; k++)
+    {
+        if (block == block_count)
+        {
+            block_count = wxMin(CLIP_BLOCK_SIZE, count - k);
+            viewClipper.OutCodes(&xs[k], &ys[k], block_count, viewCodes);
+            drawClipper.OutCodes(&xs[k], &ys[k], block_count, drawCodes);
+            host_->GetClientCoordsFromPlotX(&xs[k], blockX, block_count);
+            host_->GetClientCoordsFromPlotY(&ys[k], blockY, block_count);
+            block = 0;
+        }
+
+        viewCode1 = viewCodes[block];
+        drawCode1 = drawCodes[block];
+        pi1 = blockX[block];
+        pj1 = blockY[block];
+        block++;
+
+        x1 = xs[k];
+        y1 = ys[k];
+
+        int index = cache.index_[k];
+        if (more_sel && (sel_range.m_max < index))
+            more_sel = selection->NextRange(index, sel_range);
+        bool sel = more_sel && (sel_range.m_min <= index);
+        if (sel != selected)
+        {
+            selected = sel;
+            dc->SetPen(selected ? selectedPen : currentPen);
+        }
+
+        if ((drawCode0 & drawCode1) == wxInside)
+        {
+            xx0 = x0; yy0 = y0; xx1 = x1; yy1 = y1;
+            int clipped = viewClipper.Clip(xx0, yy0, xx1, yy1, viewCode0, viewCode1);
+            if (clipped != ClippedOut)
+            {
+                i0 = ((clipped & ClippedFirst) != 0) ? host_->GetClientCoordFromPlotX(xx0) : pi0;
+                j0 = ((clipped & ClippedFirst) != 0) ? host_->GetClientCoordFromPlotY(yy0) : pj0;
+                i1 = ((clipped & ClippedSecond) != 0) ? host_->GetClientCoordFromPlotX(xx1) : pi1;
+                j1 = ((clipped & ClippedSecond) != 0) ? host_->GetClientCoordFromPlotY(yy1) : pj1;
+
+                if ((i0 != i1) || (j0 != j1))
+                    wxPLOTCTRL_DRAW_LINE(dc, window, pen, i0, j0, i1, j1);
+            }
+        }
+
+        x0 = x1;
+        y0 = y1;
+        viewCode0 = viewCode1;
+        drawCode0 = drawCode1;
+        pi0 = pi1;
+        pj0 = pj1;
+    }
+}
+
 void wxPlotDrawerDataCurve::Draw(wxDC *WXUNUSED(dc), bool WXUNUSED(refresh))
 {}
 
@@ -1515,3 +2470,254 @@ bool wxRangeDoubleSelection::BoundRanges(const wxRangeDouble& range)
     return done;
 }
 
+
+#if wxUSE_THREADS
+
+//-----------------------------------------------------------------------------
+// wxPlotRenderThread
+//-----------------------------------------------------------------------------
+
+#define RENDER_CHECK_POINTS 16384 // points drawn between checks for a newer frame
+
+namespace {
+
+// Set the pixels of a square pen of width w centered at i, j
+inline void RenderStamp(wxPlotRenderFrame &frame, int i, int j, int w,
+                        const unsigned char *colour)
+{
+    const int width = frame.size_.x, height = frame.size_.y;
+    int i0 = wxMax(i - (w - 1)/2, 0), i1 = wxMin(i + w/2, width - 1);
+    int j0 = wxMax(j - (w - 1)/2, 0), j1 = wxMin(j + w/2, height - 1);
+
+    for (int jj = j0; jj <= j1; jj++)
+    {
+        unsigned char *p = &frame.rgba_[(size_t(jj)*width + i0)*4];
+        for (int ii = i0; ii <= i1; ii++, p += 4)
+        {
+            p[0] = colour[0];
+            p[1] = colour[1];
+            p[2] = colour[2];
+            p[3] = 255;
+        }
+    }
+}
+
+// Clip the line in pixels to the rect from -pad to the size + pad, returns
+//   false if none of it is inside
+bool RenderClipLine(double &x0, double &y0, double &x1, double &y1,
+                    const wxSize &size, double pad)
+{
+    const double dx = x1 - x0, dy = y1 - y0;
+    const double p[4] = { -dx, dx, -dy, dy };
+    const double q[4] = { x0 + pad, size.x + pad - x0, y0 + pad, size.y + pad - y0 };
+    double t0 = 0, t1 = 1;
+
+    for (int k = 0; k < 4; k++)
+    {
+        if (p[k] == 0)
+        {
+            if (q[k] < 0) return false;
+            continue;
+        }
+
+        double t = q[k]/p[k];
+        if (p[k] < 0)
+            t0 = wxMax(t0, t);
+        else
+            t1 = wxMin(t1, t);
+
+        if (t0 > t1) return false;
+    }
+
+    x1 = x0 + t1*dx;
+    y1 = y0 + t1*dy;
+    x0 = x0 + t0*dx;
+    y0 = y0 + t0*dy;
+    return true;
+}
+
+// Draw the line in pixels with Bresenham, stamping the pen at each pixel
+void RenderLine(wxPlotRenderFrame &frame, double x0, double y0, double x1, double y1,
+                int w, const unsigned char *colour)
+{
+    if (!RenderClipLine(x0, y0, x1, y1, frame.size_, w + 4))
+        return;
+
+    // rounded the same as wxPlotCtrl::GetClientCoordsFromPlotX/Y
+    int i0 = int(floor(x0 + 0.5)), j0 = int(floor(y0 + 0.5));
+    int i1 = int(floor(x1 + 0.5)), j1 = int(floor(y1 + 0.5));
+
+    int di = abs(i1 - i0), si = (i0 < i1) ? 1 : -1;
+    int dj = -abs(j1 - j0), sj = (j0 < j1) ? 1 : -1;
+    int err = di + dj;
+
+    while (true)
+    {
+        RenderStamp(frame, i0, j0, w, colour);
+        if ((i0 == i1) && (j0 == j1)) break;
+
+        int e2 = 2*err;
+        if (e2 >= dj) { err += dj; i0 += si; }
+        if (e2 <= di) { err += di; j0 += sj; }
+    }
+}
+
+} // namespace
+
+wxPlotRenderThread::wxPlotRenderThread(wxEvtHandler *handler, int id)
+                   :wxThread(wxTHREAD_JOINABLE),
+                    handler_(handler), id_(id),
+                    condition_(mutex_),
+                    next_(NULL), latest_(0), stop_(false)
+{
+}
+
+wxPlotRenderThread::~wxPlotRenderThread()
+{
+    // the thread is gone, see Stop, so these are only ours
+    delete next_;
+    for (size_t i = 0; i < done_.size(); i++)
+        delete done_[i];
+}
+
+void wxPlotRenderThread::Request(wxPlotRenderFrame *frame)
+{
+    wxCHECK_RET(frame, wxT("Invalid frame"));
+
+    wxPlotRenderFrame *dropped;
+    {
+        wxMutexLocker lock(mutex_);
+        dropped = next_;
+        next_ = frame;
+        latest_ = frame->generation_;
+        condition_.Signal();
+    }
+
+    delete dropped;
+}
+
+void wxPlotRenderThread::TakeDone(std::vector<wxPlotRenderFrame*> &frames)
+{
+    wxMutexLocker lock(mutex_);
+    frames.insert(frames.end(), done_.begin(), done_.end());
+    done_.clear();
+}
+
+void wxPlotRenderThread::Stop()
+{
+    {
+        wxMutexLocker lock(mutex_);
+        stop_ = true;
+        condition_.Signal();
+    }
+
+    Wait();
+}
+
+wxThread::ExitCode wxPlotRenderThread::Entry()
+{
+    while (true)
+    {
+        wxPlotRenderFrame *frame;
+        {
+            wxMutexLocker lock(mutex_);
+            while (!next_ && !stop_)
+                condition_.Wait();
+
+            if (stop_) break;
+
+            frame = next_;
+            next_ = NULL;
+        }
+
+        frame->complete_ = Render(*frame);
+
+        // the frame goes back even if dropped, the handler deletes it
+        {
+            wxMutexLocker lock(mutex_);
+            done_.push_back(frame);
+        }
+
+        wxQueueEvent(handler_, new wxThreadEvent(wxEVT_THREAD, id_));
+    }
+
+    return (ExitCode)0;
+}
+
+bool wxPlotRenderThread::IsStale(const wxPlotRenderFrame &frame)
+{
+    wxMutexLocker lock(mutex_);
+    return stop_ || (frame.generation_ != latest_);
+}
+
+bool wxPlotRenderThread::Render(wxPlotRenderFrame &frame)
+{
+    const int width = frame.size_.x, height = frame.size_.y;
+    if ((width <= 0) || (height <= 0))
+        return false;
+
+    frame.rgba_.assign(size_t(width)*height*4, 0);
+
+    const double zoomX = frame.zoom_.m_x, zoomY = frame.zoom_.m_y;
+    const double left = frame.view_.GetLeft(), top = frame.view_.GetTop();
+
+    for (size_t c = 0; c < frame.curves_.size(); c++)
+    {
+        const wxPlotRenderFrame::Curve &curve = frame.curves_[c];
+        const double *x_data = curve.xs_.empty() ? NULL : &curve.xs_[0];
+        const double *y_data = curve.ys_.empty() ? NULL : &curve.ys_[0];
+        const int count = int(curve.xs_.size());
+
+        wxRangeInt sel_range;
+        bool hasSel = curve.selection_.NextRange(curve.first_, sel_range);
+
+        // the segment to a point is drawn with the pen of the point before it
+        bool have0 = false, selected0 = false;
+        double x0 = 0, y0 = 0;
+
+        for (int n = 0; n < count; n++)
+        {
+            if (((n % RENDER_CHECK_POINTS) == 0) && IsStale(frame))
+                return false;
+
+            double x = zoomX*(x_data[n] - left);
+            double y = height - zoomY*(y_data[n] - top);
+
+            // gaps in the data break the line
+            if (!wxFinite(x) || !wxFinite(y))
+            {
+                have0 = false;
+                continue;
+            }
+
+            int index = curve.first_ + n;
+            if (hasSel && (index > sel_range.m_max))
+                hasSel = curve.selection_.NextRange(index, sel_range);
+            bool selected = hasSel && sel_range.Contains(index);
+
+            if (frame.drawLines_ && have0)
+            {
+                RenderLine(frame, x0, y0, x, y,
+                           selected0 ? curve.selectedWidth_ : curve.width_,
+                           selected0 ? curve.selectedColour_ : curve.colour_);
+            }
+
+            // the same 2x2 ellipse wxPlotDrawerDataCurve draws
+            if (frame.drawSymbols_ && (x > -4) && (x < width + 4) && (y > -4) && (y < height + 4))
+            {
+                int w = selected ? curve.selectedWidth_ : curve.width_;
+                RenderStamp(frame, int(floor(x + 0.5)), int(floor(y + 0.5)), w + 1,
+                            selected ? curve.selectedColour_ : curve.colour_);
+            }
+
+            x0 = x;
+            y0 = y;
+            selected0 = selected;
+            have0 = true;
+        }
+    }
+
+    return true;
+}
+
+#endif // wxUSE_THREADS
@@ -11,11 +11,14 @@
 
 #include "wx/plotctrl/range.h"
 #include <stdio.h>
+#include <limits.h>
+#include <string.h>
+
+#include <algorithm>
 
 const wxRangeInt wxEmptyRangeInt(0, -1);
 #include "wx/arrimpl.cpp"
 
-WX_DEFINE_OBJARRAY(wxArrayRangeInt);
 WX_DEFINE_OBJARRAY(wxArrayRangeIntSelection);
 
 // set this if you want to double check that that ranges are really working
@@ -93,238 +96,1296 @@ bool wxRangeInt::Delete(const wxRangeInt &r, wxRangeInt *right)
 }
 
 //=============================================================================
-// wxRangeIntSelection
+// wxArrayRangeInt
 //=============================================================================
-const wxRangeInt& wxRangeIntSelection::GetRange(int index) const
+
+int wxArrayRangeInt::Index(const wxRangeInt &range, bool fromEnd) const
 {
-    wxCHECK_MSG((index>=0) && (index<int(m_ranges.GetCount())), wxEmptyRangeInt, wxT("Invalid index"));
-    return m_ranges[index];
+    if (fromEnd)
+    {
+        const_reverse_iterator it = std::find(rbegin(), rend(), range);
+        return (it == rend()) ? wxNOT_FOUND : int(rend() - it) - 1;
+    }
+
+    const_iterator it = std::find(begin(), end(), range);
+    return (it == end()) ? wxNOT_FOUND : int(it - begin());
 }
 
-wxRangeInt wxRangeIntSelection::GetBoundingRange() const
+void wxArrayRangeInt::Add(const wxRangeInt *range)
 {
-    if (int(m_ranges.GetCount()) < 1) return wxEmptyRangeInt;
-    return wxRangeInt(m_ranges[0].m_min, m_ranges[m_ranges.GetCount()-1].m_max);
+    wxCHECK_RET(range, wxT("Invalid range"));
+    push_back(*range);
+    delete range;
 }
 
-int wxRangeIntSelection::Index(int i) const
+void wxArrayRangeInt::Insert(const wxRangeInt *range, size_t index)
 {
-    int count = m_ranges.GetCount();
-    if (count < 1) return wxNOT_FOUND;
+    wxCHECK_RET(range && (index <= size()), wxT("Invalid range or index"));
+    insert(begin() + index, *range);
+    delete range;
+}
 
-    if (i < m_ranges[0].m_min) return wxNOT_FOUND;
-    if (i > m_ranges[count-1].m_max) return wxNOT_FOUND;
+void wxArrayRangeInt::Remove(const wxRangeInt &range)
+{
+    int index = Index(range);
+    wxCHECK_RET(index != wxNOT_FOUND, wxT("Removing a range that isn't in the array"));
+    RemoveAt(index);
+}
 
-    // Binary search
-    int res, tmp, lo = 0, hi = count;
+wxRangeInt *wxArrayRangeInt::Detach(size_t index)
+{
+    wxCHECK_MSG(index < size(), NULL, wxT("Invalid index"));
+    wxRangeInt *range = new wxRangeInt((*this)[index]);
+    RemoveAt(index);
+    return range;
+}
 
-    while (lo < hi)
+void wxArrayRangeInt::Sort(CMPFUNCwxRangeInt compare)
+{
+    std::stable_sort(begin(), end(),
+        [compare](const wxRangeInt &a, const wxRangeInt &b)
+        {
+            wxRangeInt *pa = const_cast<wxRangeInt*>(&a);
+            wxRangeInt *pb = const_cast<wxRangeInt*>(&b);
+            return compare(&pa, &pb) < 0;
+        });
+}
+
+//=============================================================================
+// range list helpers, the ranges are sorted and don't overlap or touch
+//=============================================================================
+
+#define BITMAP_CHUNK_BITS    16   // log2 of the items in a wxBitmapIntSelection chunk
+#define BITMAP_CHUNK_WORDS 1024   // 64 bit words in a chunk bitmap
+#define BITMAP_CHUNK_RUNS  1024   // chunks with more runs are stored as a bitmap
+#define BITMAP_MIN_RANGES  4096   // selections with fewer ranges don't use a bitmap
+
+// both ends of the ranges are ascending
+static inline bool RangeMaxLess(const wxRangeInt &r, int i) {return r.m_max < i;}
+static inline bool RangeMinLess(int i, const wxRangeInt &r) {return i < r.m_min;}
+
+// i - 1 and i + 1 that stop at the ends of the ints instead of overflowing
+static inline int RangeDec(int i) {return (i > INT_MIN) ? i - 1 : i;}
+static inline int RangeInc(int i) {return (i < INT_MAX) ? i + 1 : i;}
+
+// add r to the end of the sorted out, joining it to the last range if they touch
+static inline void AppendRange(std::vector<wxRangeInt> &out, const wxRangeInt &r)
+{
+    if (!out.empty() && (r.m_min <= RangeInc(out.back().m_max)))
+        out.back().m_max = wxMax(out.back().m_max, r.m_max);
+    else
+        out.push_back(r);
+}
+
+// add the range to the ranges, returns false if it was already in them
+static bool SelectRangeIn(std::vector<wxRangeInt> &ranges, const wxRangeInt &range)
+{
+    // the ranges [lo, hi) overlap or touch the range
+    std::vector<wxRangeInt>::iterator lo = std::lower_bound(ranges.begin(), ranges.end(), RangeDec(range.m_min), RangeMaxLess);
+    std::vector<wxRangeInt>::iterator hi = std::upper_bound(lo, ranges.end(), RangeInc(range.m_max), RangeMinLess);
+
+    if (lo == hi)
     {
-        tmp = (lo + hi)/2;
-        res = m_ranges[tmp].Position(i);
+        ranges.insert(lo, range);
+        return true;
+    }
+
+    if ((hi - lo == 1) && lo->Contains(range))
+        return false;
+
+    // they all become one
+    lo->m_min = wxMin(lo->m_min, range.m_min);
+    lo->m_max = wxMax((hi - 1)->m_max, range.m_max);
+    ranges.erase(lo + 1, hi);
+    return true;
+}
+
+// remove the range from the ranges, returns false if none of it was in them
+static bool DeselectRangeIn(std::vector<wxRangeInt> &ranges, const wxRangeInt &range)
+{
+    // the ranges [lo, hi) overlap the range
+    std::vector<wxRangeInt>::iterator lo = std::lower_bound(ranges.begin(), ranges.end(), range.m_min, RangeMaxLess);
+    std::vector<wxRangeInt>::iterator hi = std::upper_bound(lo, ranges.end(), range.m_max, RangeMinLess);
+
+    if (lo == hi)
+        return false;
+
+    // keep the parts sticking out of either end
+    bool keepLeft  = lo->m_min < range.m_min;
+    bool keepRight = (hi - 1)->m_max > range.m_max;
+    wxRangeInt left(lo->m_min, keepLeft ? range.m_min - 1 : 0);
+    wxRangeInt right(keepRight ? range.m_max + 1 : 0, (hi - 1)->m_max);
+
+    lo = ranges.erase(lo, hi);
+    if (keepRight)
+        lo = ranges.insert(lo, right);
+    if (keepLeft)
+        ranges.insert(lo, left);
+
+    return true;
+}
 
-        if (res == 0)
-            return tmp;
-        else if (res < 0)
-            hi = tmp;
-        else //if (res > 0)
-            lo = tmp + 1;
+// out = the items in a or b
+static void UnionRangeArrays(const std::vector<wxRangeInt> &a, const std::vector<wxRangeInt> &b,
+                             std::vector<wxRangeInt> &out)
+{
+    size_t i = 0, j = 0, a_count = a.size(), b_count = b.size();
+    out.reserve(a_count + b_count);
+
+    while ((i < a_count) || (j < b_count))
+    {
+        if ((j == b_count) || ((i < a_count) && (a[i].m_min <= b[j].m_min)))
+            AppendRange(out, a[i++]);
+        else
+            AppendRange(out, b[j++]);
     }
+}
 
-    return wxNOT_FOUND;
+// out = the items in both a and b
+static void IntersectRangeArrays(const std::vector<wxRangeInt> &a, const std::vector<wxRangeInt> &b,
+                                 std::vector<wxRangeInt> &out)
+{
+    size_t i = 0, j = 0, a_count = a.size(), b_count = b.size();
+
+    while ((i < a_count) && (j < b_count))
+    {
+        wxRangeInt r(a[i].Intersect(b[j]));
+        if (!r.IsEmpty())
+            AppendRange(out, r);
+
+        if (a[i].m_max < b[j].m_max)
+            i++;
+        else
+            j++;
+    }
 }
 
-int wxRangeIntSelection::Index(const wxRangeInt &r) const
+// out = the items in a that aren't in b
+static void SubtractRangeArrays(const std::vector<wxRangeInt> &a, const std::vector<wxRangeInt> &b,
+                                std::vector<wxRangeInt> &out)
 {
-    int i, count = m_ranges.GetCount();
-    for (i=0; i<count; i++) if (m_ranges[i].Contains(r)) return i;
-    return wxNOT_FOUND;
+    size_t i, j = 0, a_count = a.size(), b_count = b.size();
+
+    for (i = 0; i < a_count; i++)
+    {
+        wxRangeInt r(a[i]);
+        bool rest = true;
+
+        while ((j < b_count) && (b[j].m_max < r.m_min))
+            j++;
+
+        // b[k] may also cover the next range of a, so j isn't moved past it
+        for (size_t k = j; (k < b_count) && (b[k].m_min <= r.m_max); k++)
+        {
+            if (b[k].m_min > r.m_min)
+                AppendRange(out, wxRangeInt(r.m_min, b[k].m_min - 1));
+
+            if (b[k].m_max >= r.m_max)
+            {
+                rest = false;
+                break;
+            }
+            r.m_min = b[k].m_max + 1;
+        }
+
+        if (rest)
+            AppendRange(out, r);
+    }
 }
 
-int wxRangeIntSelection::NearestIndex(int i) const
+//=============================================================================
+// wxBitmapIntSelection
+//=============================================================================
+
+static inline int CountBits(wxUint64 w)
 {
-    int count = m_ranges.GetCount();
-    if (count < 1) return -1;
+#if defined(__GNUC__)
+    return __builtin_popcountll(w);
+#else
+    w = w - ((w >> 1) & wxULL(0x5555555555555555));
+    w = (w & wxULL(0x3333333333333333)) + ((w >> 2) & wxULL(0x3333333333333333));
+    w = (w + (w >> 4)) & wxULL(0x0f0f0f0f0f0f0f0f);
+    return int((w * wxULL(0x0101010101010101)) >> 56);
+#endif
+}
 
-    if (i < m_ranges[0].m_min) return -1;
-    if (i > m_ranges[count-1].m_max) return count;
+// index of the lowest/highest set bit, w != 0
+static inline int LowestBit(wxUint64 w)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(w);
+#else
+    return CountBits((w & (~w + 1)) - 1);
+#endif
+}
+static inline int HighestBit(wxUint64 w)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(w);
+#else
+    int n = 0;
+    while (w >>= 1) n++;
+    return n;
+#endif
+}
 
-    // Binary search
-    int res, tmp, lo = 0, hi = count;
+// the bits lo to hi of a word, 0 <= lo <= hi <= 63
+static inline wxUint64 BitMask(int lo, int hi)
+{
+    return (~wxULL(0) << lo) & (~wxULL(0) >> (63 - hi));
+}
 
-    while (lo < hi)
+bool wxBitmapIntSelection::Chunk::Contains(int off) const
+{
+    if (!words_.empty())
+        return ((words_[off >> 6] >> (off & 63)) & 1) != 0;
+
+    std::vector<wxRangeInt>::const_iterator it = std::lower_bound(runs_.begin(), runs_.end(), off, RangeMaxLess);
+    return (it != runs_.end()) && (it->m_min <= off);
+}
+
+int wxBitmapIntSelection::Chunk::NextSet(int off) const
+{
+    if (words_.empty())
     {
-        tmp = (lo + hi)/2;
-        res = m_ranges[tmp].Position(i);
+        std::vector<wxRangeInt>::const_iterator it = std::lower_bound(runs_.begin(), runs_.end(), off, RangeMaxLess);
+        return (it == runs_.end()) ? -1 : wxMax(off, it->m_min);
+    }
 
-        if (res == 0)
-            return tmp;
-        else if ((i >= m_ranges[tmp].m_max) && (i < m_ranges[wxMin(tmp+1, count-1)].m_min))
-            return tmp;
-        else if (res < 0)
-            hi = tmp;
-        else //if (res > 0)
-            lo = tmp + 1;
+    int w = off >> 6;
+    wxUint64 bits = words_[w] & (~wxULL(0) << (off & 63));
+    while (bits == 0)
+    {
+        if (++w == BITMAP_CHUNK_WORDS)
+            return -1;
+        bits = words_[w];
     }
 
-    // oops shouldn't get here
-    wxCHECK_MSG(0, -1, wxT("Error calculating NearestIndex in wxRangeIntSelection"));
+    return (w << 6) + LowestBit(bits);
 }
 
-int wxRangeIntSelection::GetItemCount() const
+int wxBitmapIntSelection::Chunk::RunEnd(int off) const
 {
-    int i, items = 0, count = m_ranges.GetCount();
-    for (i=0; i<count; i++) items += m_ranges[i].GetRange();
-    return items;
+    if (words_.empty())
+        return std::lower_bound(runs_.begin(), runs_.end(), off, RangeMaxLess)->m_max;
+
+    // the first clear bit after off
+    int w = off >> 6;
+    wxUint64 bits = ~words_[w] & (~wxULL(0) << (off & 63));
+    while (bits == 0)
+    {
+        if (++w == BITMAP_CHUNK_WORDS)
+            return (1 << BITMAP_CHUNK_BITS) - 1;
+        bits = ~words_[w];
+    }
+
+    return (w << 6) + LowestBit(bits) - 1;
 }
 
-bool wxRangeIntSelection::DeselectRange(const wxRangeInt &range)
+int wxBitmapIntSelection::Chunk::RunStart(int off) const
 {
-    wxCHECK_MSG(!range.IsEmpty(), false, wxT("Invalid Selection Range"));
+    if (words_.empty())
+        return (std::upper_bound(runs_.begin(), runs_.end(), off, RangeMinLess) - 1)->m_min;
 
-    bool done = false;
-    int i, count = m_ranges.GetCount();
-    int nearest = count > 0 ? NearestIndex(range.m_min) : -1;
+    // the last clear bit before off
+    int w = off >> 6;
+    wxUint64 bits = (off & 63) ? (~words_[w] & BitMask(0, (off & 63) - 1)) : 0;
+    while (bits == 0)
+    {
+        if (w-- == 0)
+            return 0;
+        bits = ~words_[w];
+    }
 
-    if ((nearest < 0) || (nearest == count))
-        return false;
+    return (w << 6) + HighestBit(bits) + 1;
+}
 
-    wxRangeInt r;
-    for (i=nearest; i<int(m_ranges.GetCount()); i++)
+void wxBitmapIntSelection::Chunk::SetRange(int lo, int hi)
+{
+    if (words_.empty())
     {
-        if (range.m_max < m_ranges[i].m_min)
-            break;
-        else if (m_ranges[i].Delete(range, &r))
+        if (SelectRangeIn(runs_, wxRangeInt(lo, hi)))
         {
-            if (m_ranges[i].IsEmpty())
-            {
-                m_ranges.RemoveAt(i);
-                i = (i > 0) ? i-1 : -1;
-            }
-            else if (!r.IsEmpty())
-                m_ranges.Insert(r, i+1);
-
-            done = true;
+            Recount();
+            Compact();
         }
+        return;
     }
 
-    return done;
+    for (int w = lo >> 6; w <= (hi >> 6); w++)
+    {
+        wxUint64 bits = words_[w];
+        words_[w] |= BitMask((w == (lo >> 6)) ? (lo & 63) : 0, (w == (hi >> 6)) ? (hi & 63) : 63);
+        count_ += CountBits(words_[w]) - CountBits(bits);
+    }
+
+    starts_ = -1;
+    Compact();
 }
 
-bool wxRangeIntSelection::SelectRange(const wxRangeInt &range)
+void wxBitmapIntSelection::Chunk::ClearRange(int lo, int hi)
 {
-    wxCHECK_MSG(!range.IsEmpty(), false, wxT("Invalid Selection Range"));
+    if (words_.empty())
+    {
+        if (DeselectRangeIn(runs_, wxRangeInt(lo, hi)))
+            Recount();
+        return;
+    }
 
-    // Try to find a range that includes this one and combine it, else insert it, else append it
-    bool done = false;
-    int i, count = m_ranges.GetCount();
-    int nearest = count > 0 ? NearestIndex(range.m_min) : -1;
+    for (int w = lo >> 6; w <= (hi >> 6); w++)
+    {
+        wxUint64 bits = words_[w];
+        words_[w] &= ~BitMask((w == (lo >> 6)) ? (lo & 63) : 0, (w == (hi >> 6)) ? (hi & 63) : 63);
+        count_ -= CountBits(bits) - CountBits(words_[w]);
+    }
+
+    starts_ = -1;
+    Compact();
+}
 
-    if (nearest < 0)
+int wxBitmapIntSelection::Chunk::Starts(int off) const
+{
+    if (words_.empty())
     {
-        if (!((count > 0) && m_ranges[0].Combine(range, true)))
-            m_ranges.Insert(range, 0);
-        return true;
+        std::vector<wxRangeInt>::const_iterator it = std::lower_bound(runs_.begin(), runs_.end(), off,
+            [](const wxRangeInt &r, int i) {return r.m_min < i;});
+        return int(it - runs_.begin());
     }
-    else if (nearest == count)
+
+    // a set bit with a clear one below it starts a run
+    int w, starts = 0, last = off >> 6;
+    wxUint64 bits, carry = 0;
+    for (w = 0; w < last; w++)
     {
-        if (!((count > 0) && m_ranges[count-1].Combine(range, true)))
-            m_ranges.Add(range);
-        return true;
+        bits = words_[w];
+        starts += CountBits(bits & ~((bits << 1) | carry));
+        carry = bits >> 63;
     }
-    else
+
+    if (off & 63)
     {
-        if (m_ranges[nearest].Contains(range))
-            return false;
+        bits = words_[last] & BitMask(0, (off & 63) - 1);
+        starts += CountBits(bits & ~((bits << 1) | carry));
+    }
+
+    return starts;
+}
+
+int wxBitmapIntSelection::Chunk::StartCount() const
+{
+    if (starts_ < 0)
+        starts_ = Starts(1 << BITMAP_CHUNK_BITS);
+
+    return starts_;
+}
+
+int wxBitmapIntSelection::Chunk::NthStart(int n) const
+{
+    if (words_.empty())
+        return ((n >= 0) && (n < int(runs_.size()))) ? runs_[n].m_min : -1;
+
+    wxUint64 carry = 0;
+    for (int w = 0; (w < BITMAP_CHUNK_WORDS) && (n >= 0); w++)
+    {
+        wxUint64 bits = words_[w];
+        wxUint64 starts = bits & ~((bits << 1) | carry);
+        carry = bits >> 63;
 
-        for (i=nearest; i<count; i++)
+        int count = CountBits(starts);
+        if (n < count)
         {
-            if (m_ranges[i].Combine(range, true))
-            {
-                done = true;
-                break;
-            }
-            else if (range.m_max < m_ranges[i].m_min)
-            {
-                m_ranges.Insert(range, i);
-                return true;
-            }
+            while (n-- > 0)
+                starts &= starts - 1; // drop the lowest
+            return (w << 6) + LowestBit(starts);
         }
 
-        count = m_ranges.GetCount();
-        for (i=wxMax(nearest-1, 1); i<count; i++)
+        n -= count;
+    }
+
+    return -1;
+}
+
+void wxBitmapIntSelection::Chunk::GetWords(wxUint64 *words) const
+{
+    if (!words_.empty())
+    {
+        memcpy(words, &words_[0], BITMAP_CHUNK_WORDS*sizeof(wxUint64));
+        return;
+    }
+
+    memset(words, 0, BITMAP_CHUNK_WORDS*sizeof(wxUint64));
+    for (size_t n = 0; n < runs_.size(); n++)
+    {
+        int lo = runs_[n].m_min, hi = runs_[n].m_max;
+        for (int w = lo >> 6; w <= (hi >> 6); w++)
+            words[w] |= BitMask((w == (lo >> 6)) ? (lo & 63) : 0, (w == (hi >> 6)) ? (hi & 63) : 63);
+    }
+}
+
+void wxBitmapIntSelection::Chunk::SetWords(const wxUint64 *words)
+{
+    int w, starts = 0;
+    wxUint64 bits, carry = 0;
+
+    count_ = 0;
+    for (w = 0; w < BITMAP_CHUNK_WORDS; w++)
+    {
+        bits = words[w];
+        count_ += CountBits(bits);
+        starts += CountBits(bits & ~((bits << 1) | carry));
+        carry = bits >> 63;
+    }
+    starts_ = starts;
+
+    if (starts > BITMAP_CHUNK_RUNS)
+    {
+        words_.assign(words, words + BITMAP_CHUNK_WORDS);
+        std::vector<wxRangeInt>().swap(runs_);
+        return;
+    }
+
+    std::vector<wxUint64>().swap(words_);
+    runs_.clear();
+    runs_.reserve(starts);
+
+    // where the bits change a run starts or ends, they take turns
+    int start = -1;
+    carry = 0;
+    for (w = 0; w < BITMAP_CHUNK_WORDS; w++)
+    {
+        bits = words[w];
+        wxUint64 edges = bits ^ ((bits << 1) | carry);
+        carry = bits >> 63;
+
+        while (edges != 0)
         {
-            if (range.m_max+1 < m_ranges[i-1].m_min)
-                break;
-            else if (m_ranges[i-1].Combine(m_ranges[i], true))
+            int off = (w << 6) + LowestBit(edges);
+            edges &= edges - 1;
+
+            if (start < 0)
+                start = off;
+            else
             {
-                m_ranges.RemoveAt(i);
-                count--;
-                i--;
+                runs_.push_back(wxRangeInt(start, off - 1));
+                start = -1;
             }
         }
     }
 
-#ifdef CHECK_RANGES
-    printf("Selecting ranges %d %d count %d\n", range.m_min, range.m_max, m_ranges.GetCount());
+    if (start >= 0)
+        runs_.push_back(wxRangeInt(start, (1 << BITMAP_CHUNK_BITS) - 1));
+}
 
-    for (i=1; i<int(m_ranges.GetCount()); i++)
-    {
-        if (m_ranges[i-1].Contains(m_ranges[i]))
-            printf("Error in Selecting ranges %d %d, %d %d count %d\n", m_ranges[i-1].m_min, m_ranges[i-1].m_max, m_ranges[i].m_min, m_ranges[i].m_max, m_ranges.GetCount());
-        if (m_ranges[i-1].Touches(m_ranges[i]))
-            printf("Could have minimzed ranges %d %d, %d %d count %d\n", m_ranges[i-1].m_min, m_ranges[i-1].m_max, m_ranges[i].m_min, m_ranges[i].m_max, m_ranges.GetCount());
-    }
-    fflush(stdout);
-#endif // CHECK_RANGES
+void wxBitmapIntSelection::Chunk::Compact()
+{
+    const int chunk_size = 1 << BITMAP_CHUNK_BITS;
 
-    return done;
+    // the runs are fewer than the items and one more than the gaps at most
+    if (words_.empty() ? (runs_.size() <= BITMAP_CHUNK_RUNS)
+                       : ((count_ > BITMAP_CHUNK_RUNS/2) && (count_ < chunk_size - BITMAP_CHUNK_RUNS/2)))
+        return;
+
+    wxUint64 words[BITMAP_CHUNK_WORDS];
+    GetWords(words);
+    SetWords(words);
 }
 
-bool wxRangeIntSelection::BoundRanges(const wxRangeInt& range)
+void wxBitmapIntSelection::Chunk::Combine(const Chunk &other, Op op, Chunk *changed)
 {
-    wxCHECK_MSG(!range.IsEmpty(), false, wxT("Invalid Bounding Range"));
-    int i, count = m_ranges.GetCount();
-    bool done = false;
+    if (changed)
+        changed->key_ = key_;
 
-    for (i = 0; i < count; i++)
+    // two lists of runs are merged as lists
+    if (words_.empty() && other.words_.empty())
     {
-        if (m_ranges[i].m_min >= range.m_min)
-            break;
-
-        if (m_ranges[i].m_max < range.m_min) // range is out of bounds
+        std::vector<wxRangeInt> result, diff;
+        switch (op)
         {
-            done = true;
-            m_ranges.RemoveAt(i);
-            count--;
-            i--;
+            case Op::UNION :
+                UnionRangeArrays(runs_, other.runs_, result);
+                if (changed) SubtractRangeArrays(other.runs_, runs_, diff);
+                break;
+            case Op::INTERSECT :
+                IntersectRangeArrays(runs_, other.runs_, result);
+                if (changed) SubtractRangeArrays(runs_, other.runs_, diff);
+                break;
+            case Op::SUBTRACT :
+                SubtractRangeArrays(runs_, other.runs_, result);
+                if (changed) IntersectRangeArrays(runs_, other.runs_, diff);
+                break;
         }
-        else
+
+        runs_.swap(result);
+        Recount();
+        Compact();
+
+        if (changed)
         {
-            done = true;
-            m_ranges[i].m_min = range.m_min;
-            break;
+            changed->runs_.swap(diff);
+            changed->words_.clear();
+            changed->Recount();
+            changed->Compact();
         }
+        return;
     }
 
-    for (i = m_ranges.GetCount() - 1; i >= 0; i--)
+    // else a word at a time, no branches so the compiler can vectorize it
+    wxUint64 a[BITMAP_CHUNK_WORDS], b[BITMAP_CHUNK_WORDS];
+    GetWords(a);
+    other.GetWords(b);
+
+    int w;
+    switch (op)
     {
-        if (m_ranges[i].m_max <= range.m_max)
+        case Op::UNION :
+            for (w = 0; w < BITMAP_CHUNK_WORDS; w++)
+            {
+                wxUint64 x = a[w], y = b[w];
+                a[w] = x | y;
+                b[w] = y & ~x;
+            }
+            break;
+        case Op::INTERSECT :
+            for (w = 0; w < BITMAP_CHUNK_WORDS; w++)
+            {
+                wxUint64 x = a[w], y = b[w];
+                a[w] = x & y;
+                b[w] = x & ~y;
+            }
+            break;
+        case Op::SUBTRACT :
+            for (w = 0; w < BITMAP_CHUNK_WORDS; w++)
+            {
+                wxUint64 x = a[w], y = b[w];
+                a[w] = x & ~y;
+                b[w] = x & y;
+            }
             break;
+    }
 
-        if (m_ranges[i].m_min > range.m_max) // range is out of bounds
-        {
-            done = true;
-            m_ranges.RemoveAt(i);
-        }
+    SetWords(a);
+    if (changed)
+        changed->SetWords(b);
+}
+
+int wxBitmapIntSelection::Chunk::LastSet() const
+{
+    if (words_.empty())
+        return runs_.empty() ? -1 : runs_.back().m_max;
+
+    for (int w = BITMAP_CHUNK_WORDS - 1; w >= 0; w--)
+    {
+        if (words_[w] != 0)
+            return (w << 6) + HighestBit(words_[w]);
+    }
+
+    return -1;
+}
+
+void wxBitmapIntSelection::Chunk::Recount()
+{
+    starts_ = -1;
+    count_ = 0;
+    for (size_t n = 0; n < runs_.size(); n++)
+        count_ += runs_[n].GetRange();
+    for (size_t n = 0; n < words_.size(); n++)
+        count_ += CountBits(words_[n]);
+}
+
+size_t wxBitmapIntSelection::ChunkIndex(int key) const
+{
+    size_t lo = 0, hi = m_chunks.size();
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi)/2;
+        if (m_chunks[mid].key_ < key)
+            lo = mid + 1;
         else
-        {
-            done = true;
-            m_ranges[i].m_max = range.m_max;
-            break;
-        }
+            hi = mid;
     }
+    return lo;
+}
 
-    return done;
+void wxBitmapIntSelection::Assign(const wxArrayRangeInt &ranges)
+{
+    Clear();
+    for (size_t n = 0; n < ranges.GetCount(); n++)
+        SetRange(ranges[n]);
+}
+
+void wxBitmapIntSelection::GetRanges(wxArrayRangeInt &ranges) const
+{
+    ranges.Clear();
+    ranges.Alloc(GetRunCount());
+
+    wxRangeInt range;
+    for (int i = 0; NextRange(i, range); i = range.m_max + 1)
+    {
+        ranges.Add(range);
+        if (range.m_max == INT_MAX) break;
+    }
+}
+
+bool wxBitmapIntSelection::Contains(int i) const
+{
+    if (i < 0) return false;
+
+    size_t c = ChunkIndex(i >> BITMAP_CHUNK_BITS);
+    return (c < m_chunks.size()) && (m_chunks[c].key_ == (i >> BITMAP_CHUNK_BITS)) &&
+           m_chunks[c].Contains(i & ((1 << BITMAP_CHUNK_BITS) - 1));
+}
+
+int wxBitmapIntSelection::GetItemCount() const
+{
+    int count = 0;
+    for (size_t c = 0; c < m_chunks.size(); c++)
+        count += m_chunks[c].count_;
+    return count;
+}
+
+bool wxBitmapIntSelection::Joined(size_t c) const
+{
+    return (c > 0) && (m_chunks[c-1].key_ == m_chunks[c].key_ - 1) && m_chunks[c].Contains(0) &&
+           m_chunks[c-1].Contains((1 << BITMAP_CHUNK_BITS) - 1);
 }
 
+void wxBitmapIntSelection::UpdateRunStarts() const
+{
+    if (m_runCount >= 0)
+        return;
+
+    // only the chunks changed since count their runs again
+    m_runStarts.resize(m_chunks.size() + 1);
+    m_runStarts[0] = 0;
+    for (size_t c = 0; c < m_chunks.size(); c++)
+        m_runStarts[c+1] = m_runStarts[c] + m_chunks[c].StartCount() - (Joined(c) ? 1 : 0);
+
+    m_runCount = m_runStarts.back();
+}
+
+int wxBitmapIntSelection::GetRunCount() const
+{
+    UpdateRunStarts();
+    return m_runCount;
+}
+
+int wxBitmapIntSelection::RunsBefore(int i) const
+{
+    if (i <= 0) return 0;
+    UpdateRunStarts();
+
+    const int key = i >> BITMAP_CHUNK_BITS;
+    size_t c = ChunkIndex(key);
+    int runs = m_runStarts[c];
+
+    if ((c < m_chunks.size()) && (m_chunks[c].key_ == key))
+    {
+        int off = i & ((1 << BITMAP_CHUNK_BITS) - 1);
+        runs += m_chunks[c].Starts(off);
+        // the set item at 0 doesn't start a run that came from the chunk before
+        if ((off > 0) && Joined(c))
+            runs--;
+    }
+
+    return runs;
+}
+
+bool wxBitmapIntSelection::GetRun(int index, wxRangeInt &range) const
+{
+    if ((index < 0) || (index >= GetRunCount()))
+        return false;
+
+    // the last chunk with fewer runs starting before it
+    size_t c = std::upper_bound(m_runStarts.begin(), m_runStarts.end(), index) - m_runStarts.begin() - 1;
+    int n = index - m_runStarts[c] + (Joined(c) ? 1 : 0);
+    int off = m_chunks[c].NthStart(n);
+    wxCHECK_MSG(off >= 0, false, wxT("Invalid run count"));
+
+    return NextRange((m_chunks[c].key_ << BITMAP_CHUNK_BITS) + off, range);
+}
+
+int wxBitmapIntSelection::RunIndex(int i) const
+{
+    wxRangeInt range;
+    if (!Contains(i) || !NextRange(i, range))
+        return wxNOT_FOUND;
+
+    return RunsBefore(range.m_min);
+}
+
+int wxBitmapIntSelection::NearestRunIndex(int i) const
+{
+    // the runs before the next one, and it if it starts at or before i
+    wxRangeInt range;
+    if (!NextRange(i, range))
+        return GetRunCount() - 1;
+
+    return RunsBefore(range.m_min) - ((range.m_min <= i) ? 0 : 1);
+}
+
+bool wxBitmapIntSelection::Combine(const wxBitmapIntSelection &other, Op op, wxBitmapIntSelection *changed)
+{
+    if (changed)
+        changed->Clear();
+
+    std::vector<Chunk> result;
+    result.reserve(m_chunks.size() + ((op == Op::UNION) ? other.m_chunks.size() : 0));
+
+    bool done = false;
+    size_t i = 0, j = 0, count = m_chunks.size(), other_count = other.m_chunks.size();
+
+    // walk both lists of chunks by key
+    while ((i < count) || (j < other_count))
+    {
+        if ((j == other_count) || ((i < count) && (m_chunks[i].key_ < other.m_chunks[j].key_)))
+        {
+            // only in this, removed by an intersection
+            if (op == Op::INTERSECT)
+            {
+                done = true;
+                if (changed)
+                    changed->m_chunks.push_back(std::move(m_chunks[i]));
+            }
+            else
+                result.push_back(std::move(m_chunks[i]));
+            i++;
+        }
+        else if ((i == count) || (other.m_chunks[j].key_ < m_chunks[i].key_))
+        {
+            // only in the other, added by a union
+            if (op == Op::UNION)
+            {
+                done = true;
+                result.push_back(other.m_chunks[j]);
+                if (changed)
+                    changed->m_chunks.push_back(other.m_chunks[j]);
+            }
+            j++;
+        }
+        else
+        {
+            Chunk &chunk = m_chunks[i];
+            Chunk diff;
+            int items = chunk.count_;
+            chunk.Combine(other.m_chunks[j], op, changed ? &diff : NULL);
+            done |= (chunk.count_ != items);
+
+            if (chunk.count_ > 0)
+                result.push_back(std::move(chunk));
+            if (changed && (diff.count_ > 0))
+                changed->m_chunks.push_back(std::move(diff));
+            i++;
+            j++;
+        }
+    }
+
+    m_chunks.swap(result);
+    if (done)
+        m_runCount = -1;
+
+    return done;
+}
+
+wxRangeInt wxBitmapIntSelection::GetBoundingRange() const
+{
+    if (m_chunks.empty()) return wxEmptyRangeInt;
+
+    const Chunk &first = m_chunks.front(), &last = m_chunks.back();
+    return wxRangeInt((first.key_ << BITMAP_CHUNK_BITS) + first.NextSet(0),
+                      (last.key_ << BITMAP_CHUNK_BITS) + last.LastSet());
+}
+
+bool wxBitmapIntSelection::NextRange(int i, wxRangeInt &range) const
+{
+    const int chunk_size = 1 << BITMAP_CHUNK_BITS;
+    i = wxMax(i, 0);
+
+    // the first set item at or after i
+    size_t c = ChunkIndex(i >> BITMAP_CHUNK_BITS);
+    int start = -1;
+    for (; c < m_chunks.size(); c++)
+    {
+        int base = m_chunks[c].key_ << BITMAP_CHUNK_BITS;
+        int off = m_chunks[c].NextSet(wxMax(i - base, 0));
+        if (off >= 0)
+        {
+            start = base + off;
+            break;
+        }
+    }
+
+    if (start < 0)
+        return false;
+
+    // the run may have started in this chunk or in the ones before it
+    size_t first = c;
+    int off = m_chunks[first].RunStart(start - (m_chunks[first].key_ << BITMAP_CHUNK_BITS));
+    while ((off == 0) && (first > 0) && (m_chunks[first-1].key_ == m_chunks[first].key_ - 1) &&
+           m_chunks[first-1].Contains(chunk_size - 1))
+    {
+        first--;
+        off = m_chunks[first].RunStart(chunk_size - 1);
+    }
+    range.m_min = (m_chunks[first].key_ << BITMAP_CHUNK_BITS) + off;
+
+    // and it may go on in the chunks after it
+    off = m_chunks[c].RunEnd(start - (m_chunks[c].key_ << BITMAP_CHUNK_BITS));
+    while ((off == chunk_size - 1) && (c + 1 < m_chunks.size()) &&
+           (m_chunks[c+1].key_ == m_chunks[c].key_ + 1) && m_chunks[c+1].Contains(0))
+    {
+        c++;
+        off = m_chunks[c].RunEnd(0);
+    }
+    range.m_max = (m_chunks[c].key_ << BITMAP_CHUNK_BITS) + off;
+
+    return true;
+}
+
+bool wxBitmapIntSelection::SetRange(const wxRangeInt &range)
+{
+    wxCHECK_MSG(!range.IsEmpty() && (range.m_min >= 0), false, wxT("Invalid Selection Range"));
+
+    const int mask = (1 << BITMAP_CHUNK_BITS) - 1;
+    bool done = false;
+
+    for (int key = range.m_min >> BITMAP_CHUNK_BITS; key <= (range.m_max >> BITMAP_CHUNK_BITS); key++)
+    {
+        size_t c = ChunkIndex(key);
+        if ((c == m_chunks.size()) || (m_chunks[c].key_ != key))
+        {
+            m_chunks.insert(m_chunks.begin() + c, Chunk());
+            m_chunks[c].key_ = key;
+        }
+
+        Chunk &chunk = m_chunks[c];
+        int count = chunk.count_;
+        chunk.SetRange((key == (range.m_min >> BITMAP_CHUNK_BITS)) ? (range.m_min & mask) : 0,
+                       (key == (range.m_max >> BITMAP_CHUNK_BITS)) ? (range.m_max & mask) : mask);
+        done |= (chunk.count_ != count);
+    }
+
+    if (done)
+        m_runCount = -1;
+
+    return done;
+}
+
+bool wxBitmapIntSelection::ClearRange(const wxRangeInt &range)
+{
+    wxCHECK_MSG(!range.IsEmpty(), false, wxT("Invalid Selection Range"));
+
+    const int mask = (1 << BITMAP_CHUNK_BITS) - 1;
+    bool done = false;
+
+    // only the chunks that are there need looking at
+    size_t c = ChunkIndex(wxMax(range.m_min, 0) >> BITMAP_CHUNK_BITS);
+    while ((c < m_chunks.size()) && (m_chunks[c].key_ <= (range.m_max >> BITMAP_CHUNK_BITS)))
+    {
+        Chunk &chunk = m_chunks[c];
+        int base = chunk.key_ << BITMAP_CHUNK_BITS;
+        int count = chunk.count_;
+        chunk.ClearRange(wxMax(range.m_min - base, 0), wxMin(range.m_max - base, mask));
+        done |= (chunk.count_ != count);
+
+        if (chunk.count_ == 0)
+            m_chunks.erase(m_chunks.begin() + c);
+        else
+            c++;
+    }
+
+    if (done)
+        m_runCount = -1;
+
+    return done;
+}
+
+//=============================================================================
+// wxRangeIntSelection
+//=============================================================================
+
+void wxRangeIntSelection::Copy(const wxRangeIntSelection &source)
+{
+    m_ranges = source.m_ranges;
+    m_rangesValid = source.m_rangesValid;
+    m_bitmap = source.m_bitmap;
+    m_useBitmap = source.m_useBitmap;
+}
+
+const wxArrayRangeInt& wxRangeIntSelection::Ranges() const
+{
+    if (!m_rangesValid)
+    {
+        m_bitmap.GetRanges(m_ranges);
+        m_rangesValid = true;
+    }
+
+    return m_ranges;
+}
+
+void wxRangeIntSelection::UseRanges()
+{
+    if (!m_useBitmap)
+        return;
+
+    Ranges();
+    m_bitmap.Clear();
+    m_useBitmap = false;
+}
+
+void wxRangeIntSelection::Optimize()
+{
+    if (m_useBitmap)
+    {
+        // back to the ranges when there are few of them
+        if (m_bitmap.GetRunCount() < BITMAP_MIN_RANGES/2)
+            UseRanges();
+
+        return;
+    }
+
+    // the bitmap is smaller when the ranges and gaps are short
+    int count = m_ranges.GetCount();
+    if ((count < BITMAP_MIN_RANGES) || (m_ranges[0].m_min < 0) ||
+        (GetBoundingRange().GetRange()/8 > count*int(sizeof(wxRangeInt))))
+        return;
+
+    m_bitmap.Assign(m_ranges);
+    wxArrayRangeInt().swap(m_ranges);
+    m_rangesValid = false;
+    m_useBitmap = true;
+}
+
+int wxRangeIntSelection::GetCount() const
+{
+    return m_useBitmap ? m_bitmap.GetRunCount() : int(m_ranges.GetCount());
+}
+
+const wxArrayRangeInt& wxRangeIntSelection::GetRangeArray() const
+{
+    return Ranges();
+}
+
+wxRangeInt wxRangeIntSelection::GetRange(int index) const
+{
+    wxCHECK_MSG((index>=0) && (index<GetCount()), wxEmptyRangeInt, wxT("Invalid index"));
+
+    if (m_useBitmap)
+    {
+        wxRangeInt range;
+        m_bitmap.GetRun(index, range);
+        return range;
+    }
+
+    return m_ranges[index];
+}
+
+wxRangeInt wxRangeIntSelection::GetBoundingRange() const
+{
+    if (m_useBitmap) return m_bitmap.GetBoundingRange();
+    if (m_ranges.IsEmpty()) return wxEmptyRangeInt;
+    return wxRangeInt(m_ranges[0].m_min, m_ranges.Last().m_max);
+}
+
+void wxRangeIntSelection::Clear()
+{
+    m_ranges.Clear();
+    m_rangesValid = true;
+    m_bitmap.Clear();
+    m_useBitmap = false;
+}
+
+bool wxRangeIntSelection::Contains(int i) const
+{
+    if (m_useBitmap) return m_bitmap.Contains(i);
+    return Index(i) != wxNOT_FOUND;
+}
+
+bool wxRangeIntSelection::Contains(const wxRangeInt &range) const
+{
+    wxRangeInt r;
+    return NextRange(range.m_min, r) && r.Contains(range);
+}
+
+int wxRangeIntSelection::Index(int i) const
+{
+    if (m_useBitmap) return m_bitmap.RunIndex(i);
+
+    const wxArrayRangeInt &ranges = m_ranges;
+
+    // the first range that doesn't end before i
+    wxArrayRangeInt::const_iterator it = std::lower_bound(ranges.begin(), ranges.end(), i, RangeMaxLess);
+
+    if ((it == ranges.end()) || (i < it->m_min))
+        return wxNOT_FOUND;
+
+    return it - ranges.begin();
+}
+
+int wxRangeIntSelection::Index(const wxRangeInt &r) const
+{
+    int index = Index(r.m_min);
+    if ((index != wxNOT_FOUND) && (r.m_max <= GetRange(index).m_max))
+        return index;
+
+    return wxNOT_FOUND;
+}
+
+int wxRangeIntSelection::NearestIndex(int i) const
+{
+    int count = GetCount();
+    if (count < 1) return -1;
+
+    if (m_useBitmap)
+    {
+        int index = m_bitmap.NearestRunIndex(i);
+        return (index == count - 1) && (i > GetBoundingRange().m_max) ? count : index;
+    }
+
+    const wxArrayRangeInt &ranges = m_ranges;
+
+    if (i < ranges[0].m_min) return -1;
+    if (i > ranges[count-1].m_max) return count;
+
+    // the last range that starts at or before i
+    wxArrayRangeInt::const_iterator it = std::upper_bound(ranges.begin(), ranges.end(), i, RangeMinLess);
+    return (it - ranges.begin()) - 1;
+}
+
+bool wxRangeIntSelection::NextRange(int i, wxRangeInt &range) const
+{
+    if (m_useBitmap)
+        return m_bitmap.NextRange(i, range);
+
+    wxArrayRangeInt::const_iterator it = std::lower_bound(m_ranges.begin(), m_ranges.end(), i, RangeMaxLess);
+    if (it == m_ranges.end())
+        return false;
+
+    range = *it;
+    return true;
+}
+
+int wxRangeIntSelection::GetItemCount() const
+{
+    if (m_useBitmap) return m_bitmap.GetItemCount();
+
+    int i, items = 0, count = m_ranges.GetCount();
+    for (i=0; i<count; i++) items += m_ranges[i].GetRange();
+    return items;
+}
+
+bool wxRangeIntSelection::DeselectRange(const wxRangeInt &range)
+{
+    wxCHECK_MSG(!range.IsEmpty(), false, wxT("Invalid Selection Range"));
+
+    if (m_useBitmap)
+    {
+        if (!m_bitmap.ClearRange(range))
+            return false;
+
+        m_rangesValid = false;
+        return true;
+    }
+
+    return DeselectRangeIn(m_ranges, range);
+}
+
+bool wxRangeIntSelection::SelectRange(const wxRangeInt &range)
+{
+    wxCHECK_MSG(!range.IsEmpty(), false, wxT("Invalid Selection Range"));
+
+    if (m_useBitmap && (range.m_min >= 0))
+    {
+        if (!m_bitmap.SetRange(range))
+            return false;
+
+        m_rangesValid = false;
+        return true;
+    }
+
+    UseRanges();
+    bool done = SelectRangeIn(m_ranges, range);
+
+#ifdef CHECK_RANGES
+    printf("Selecting ranges %d %d count %d\n", range.m_min, range.m_max, m_ranges.GetCount());
+
+    for (int i=1; i<int(m_ranges.GetCount()); i++)
+    {
+        if (m_ranges[i-1].Contains(m_ranges[i]))
+            printf("Error in Selecting ranges %d %d, %d %d count %d\n", m_ranges[i-1].m_min, m_ranges[i-1].m_max, m_ranges[i].m_min, m_ranges[i].m_max, m_ranges.GetCount());
+        if (m_ranges[i-1].Touches(m_ranges[i]))
+            printf("Could have minimzed ranges %d %d, %d %d count %d\n", m_ranges[i-1].m_min, m_ranges[i-1].m_max, m_ranges[i].m_min, m_ranges[i].m_max, m_ranges.GetCount());
+    }
+    fflush(stdout);
+#endif // CHECK_RANGES
+
+    return done;
+}
+
+bool wxRangeIntSelection::Combine(const wxArrayRangeInt &ranges, const wxBitmapIntSelection *bitmap,
+                                  wxBitmapIntSelection::Op op, wxRangeIntSelection *changed)
+{
+    typedef wxBitmapIntSelection::Op Op;
+
+    // the bitmap only holds ints >= 0, the rest of an intersection or
+    //   subtraction is outside of a bitmap anyway
+    bool useBitmap = m_useBitmap || (bitmap != NULL);
+    if (useBitmap && !m_useBitmap && !m_ranges.IsEmpty() && (m_ranges[0].m_min < 0))
+        useBitmap = false;
+    if (useBitmap && !bitmap && (op == Op::UNION) && !ranges.IsEmpty() && (ranges[0].m_min < 0))
+        useBitmap = false;
+
+    if (!useBitmap)
+    {
+        wxArrayRangeInt other;
+        if (bitmap)
+            bitmap->GetRanges(other);
+        const wxArrayRangeInt &b = bitmap ? other : ranges;
+
+        UseRanges();
+        wxArrayRangeInt result, diff;
+        switch (op)
+        {
+            case Op::UNION :
+                UnionRangeArrays(m_ranges, b, result);
+                if (changed) SubtractRangeArrays(b, m_ranges, diff);
+                break;
+            case Op::INTERSECT :
+                IntersectRangeArrays(m_ranges, b, result);
+                if (changed) SubtractRangeArrays(m_ranges, b, diff);
+                break;
+            case Op::SUBTRACT :
+                SubtractRangeArrays(m_ranges, b, result);
+                if (changed) IntersectRangeArrays(m_ranges, b, diff);
+                break;
+        }
+
+        bool done = (result != m_ranges);
+        m_ranges.swap(result);
+        Optimize();
+
+        if (changed)
+        {
+            changed->Clear();
+            changed->m_ranges.swap(diff);
+            changed->Optimize();
+        }
+        return done;
+    }
+
+    if (!m_useBitmap)
+    {
+        m_bitmap.Assign(m_ranges);
+        wxArrayRangeInt().swap(m_ranges);
+        m_rangesValid = false;
+        m_useBitmap = true;
+    }
+
+    // only the part of the ranges that can change this needs to be a bitmap
+    wxBitmapIntSelection other;
+    if (!bitmap)
+    {
+        wxRangeInt bounds(0, INT_MAX);
+        if (op != Op::UNION)
+            bounds = bounds.Intersect(m_bitmap.GetBoundingRange());
+
+        size_t n = std::lower_bound(ranges.begin(), ranges.end(), bounds.m_min, RangeMaxLess) - ranges.begin();
+        for (; (n < ranges.GetCount()) && (ranges[n].m_min <= bounds.m_max); n++)
+            other.SetRange(ranges[n].Intersect(bounds));
+
+        bitmap = &other;
+    }
+
+    wxBitmapIntSelection diff;
+    bool done = m_bitmap.Combine(*bitmap, op, changed ? &diff : NULL);
+    if (done)
+        m_rangesValid = false;
+    Optimize();
+
+    if (changed)
+    {
+        changed->Clear();
+        changed->m_bitmap = std::move(diff);
+        changed->m_rangesValid = false;
+        changed->m_useBitmap = true;
+        changed->Optimize();
+    }
+    return done;
+}
+
+bool wxRangeIntSelection::SelectRanges(const wxRangeIntSelection &ranges, wxRangeIntSelection *changed)
+{
+    return Combine(ranges.m_ranges, ranges.m_useBitmap ? &ranges.m_bitmap : NULL,
+                   wxBitmapIntSelection::Op::UNION, changed);
+}
+
+bool wxRangeIntSelection::DeselectRanges(const wxRangeIntSelection &ranges, wxRangeIntSelection *changed)
+{
+    return Combine(ranges.m_ranges, ranges.m_useBitmap ? &ranges.m_bitmap : NULL,
+                   wxBitmapIntSelection::Op::SUBTRACT, changed);
+}
+
+bool wxRangeIntSelection::Union(const wxArrayRangeInt &ranges)
+{
+    return Combine(ranges, NULL, wxBitmapIntSelection::Op::UNION, NULL);
+}
+
+bool wxRangeIntSelection::Intersect(const wxArrayRangeInt &ranges)
+{
+    return Combine(ranges, NULL, wxBitmapIntSelection::Op::INTERSECT, NULL);
+}
+
+bool wxRangeIntSelection::Subtract(const wxArrayRangeInt &ranges)
+{
+    return Combine(ranges, NULL, wxBitmapIntSelection::Op::SUBTRACT, NULL);
+}
+
+bool wxRangeIntSelection::Union(const wxRangeIntSelection &ranges)
+{
+    return SelectRanges(ranges);
+}
+
+bool wxRangeIntSelection::Intersect(const wxRangeIntSelection &ranges)
+{
+    return Combine(ranges.m_ranges, ranges.m_useBitmap ? &ranges.m_bitmap : NULL,
+                   wxBitmapIntSelection::Op::INTERSECT, NULL);
+}
+
+bool wxRangeIntSelection::Subtract(const wxRangeIntSelection &ranges)
+{
+    return DeselectRanges(ranges);
+}
+
+bool wxRangeIntSelection::Invert(const wxRangeInt &bounds)
+{
+    wxCHECK_MSG(!bounds.IsEmpty(), false, wxT("Invalid Bounding Range"));
+
+    // the bounds less this as bitmaps if they can be
+    if (m_useBitmap && (bounds.m_min >= 0))
+    {
+        wxBitmapIntSelection result;
+        result.SetRange(bounds);
+        result.Combine(m_bitmap, wxBitmapIntSelection::Op::SUBTRACT);
+
+        m_bitmap = std::move(result);
+        m_rangesValid = false;
+        Optimize();
+        return true;
+    }
+
+    wxArrayRangeInt result;
+    SubtractRangeArrays(wxArrayRangeInt(1, bounds), Ranges(), result);
+
+    if (result == Ranges())
+        return false;
+
+    UseRanges();
+    m_ranges.swap(result);
+    Optimize();
+    return true;
+}
+
+bool wxRangeIntSelection::BoundRanges(const wxRangeInt& range)
+{
+    wxCHECK_MSG(!range.IsEmpty(), false, wxT("Invalid Bounding Range"));
+    return Intersect(wxArrayRangeInt(1, range));
+}